@@ -6,6 +6,7 @@
 #include "LoopGame.h"
 #include "GlobalLog.h"
 #include "Settings.h"
+#include "Profiling/Trace.h"
 #include "Rendering/Renderer.h"
 
 
@@ -20,7 +21,7 @@ void runGameThread(
 	loop.run();
 }
 catch (const std::exception& error) {
-	GlobalLog.Write(std::string("Game thread exception: ") + error.what());
+	LOG_ERROR(std::string("Game thread exception: ") + error.what());
 }
 
 
@@ -35,7 +36,7 @@ void runRenderThread(
 	renderer.run();
 }
 catch (const std::exception& error) {
-	GlobalLog.Write(std::string("Rendering thread exception: ") + error.what());
+	LOG_ERROR(std::string("Rendering thread exception: ") + error.what());
 }
 
 
@@ -44,22 +45,27 @@ void Application::run() {
 	Settings settings;
 
 	std::atomic_bool applicationShouldTerminate;
-	auto sharedGameRendererState{std::make_shared<SharedGameRendererState>()};
-
-	std::jthread renderThread(
-		runRenderThread,
-		std::cref(settings),
-		window.get(),
-		std::ref(applicationShouldTerminate),
-		sharedGameRendererState
-	);
-
-	std::jthread gameThread(
-		runGameThread,
-		std::cref(settings),
-		window.get(),
-		std::ref(applicationShouldTerminate),
-		sharedGameRendererState
-	);
+	auto sharedGameRendererState{std::make_shared<SharedGameRendererState>(settings)};
+
+	{
+		std::jthread renderThread(
+			runRenderThread,
+			std::cref(settings),
+			window.get(),
+			std::ref(applicationShouldTerminate),
+			sharedGameRendererState
+		);
+
+		std::jthread gameThread(
+			runGameThread,
+			std::cref(settings),
+			window.get(),
+			std::ref(applicationShouldTerminate),
+			sharedGameRendererState
+		);
+	}
+
+	// Both threads have been joined, so their trace buffers are complete
+	TRACE_FLUSH("trace.json");
 }
 
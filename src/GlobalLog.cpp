@@ -1,5 +1,51 @@
 #include "GlobalLog.h"
 
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+
 
 
 Logger GlobalLog("log.txt");
+
+
+
+namespace {
+
+struct FatalSignal {
+	int signal;
+	const char* message;
+};
+
+// The messages are written out in full, as the crash may have happened inside the allocator
+constexpr FatalSignal FATAL_SIGNALS[] = {
+	{SIGSEGV, "Fatal signal SIGSEGV"},
+	{SIGABRT, "Fatal signal SIGABRT"},
+	{SIGFPE, "Fatal signal SIGFPE"},
+	{SIGILL, "Fatal signal SIGILL"}
+};
+
+// Not strictly async signal safe, but the process is going down anyway and losing the log is worse. Nothing here
+// allocates before the log is drained.
+void handleFatalSignal(int signal) {
+	for (const auto& fatalSignal : FATAL_SIGNALS) {
+		if (fatalSignal.signal == signal) LOG_ERROR(fatalSignal.message);
+	}
+	GlobalLog.Drain();
+	std::signal(signal, SIG_DFL);
+	std::raise(signal);
+}
+
+}
+
+
+
+void installLogCrashHandlers() {
+	for (const auto& fatalSignal : FATAL_SIGNALS) std::signal(fatalSignal.signal, handleFatalSignal);
+
+	std::set_terminate([]() {
+		LOG_ERROR("std::terminate called");
+		GlobalLog.Drain();
+		std::abort();
+	});
+}
@@ -3,3 +3,37 @@
 
 
 extern Logger GlobalLog;
+
+// Drains the global log before the process dies from std::terminate or a fatal signal
+void installLogCrashHandlers();
+
+
+// Messages below this level are compiled out entirely, 0 = debug, 1 = info, 2 = warning, 3 = error. Compiled out
+// messages are still type checked, but never built.
+#ifndef REVETTE_LOG_LEVEL
+#ifdef NDEBUG
+#define REVETTE_LOG_LEVEL 1
+#else
+#define REVETTE_LOG_LEVEL 0
+#endif
+#endif
+
+#if REVETTE_LOG_LEVEL <= 0
+#define LOG_DEBUG(message) GlobalLog.Write(LogLevel::Debug, message)
+#else
+#define LOG_DEBUG(message) do { if constexpr (false) GlobalLog.Write(message); } while (false)
+#endif
+
+#if REVETTE_LOG_LEVEL <= 1
+#define LOG_INFO(message) GlobalLog.Write(LogLevel::Info, message)
+#else
+#define LOG_INFO(message) do { if constexpr (false) GlobalLog.Write(message); } while (false)
+#endif
+
+#if REVETTE_LOG_LEVEL <= 2
+#define LOG_WARNING(message) GlobalLog.Write(LogLevel::Warning, message)
+#else
+#define LOG_WARNING(message) do { if constexpr (false) GlobalLog.Write(message); } while (false)
+#endif
+
+#define LOG_ERROR(message) GlobalLog.Write(LogLevel::Error, message)
@@ -1,17 +1,155 @@
 #include "Logger.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
 
 
-void Logger::Write(const char* message) {
-	std::lock_guard<std::mutex> lock(fileMutex);
-	file << message << "\n";
+
+namespace {
+
+constexpr auto WRITER_INTERVAL = std::chrono::milliseconds(10);
+constexpr auto CRASH_DRAIN_TIMEOUT = std::chrono::milliseconds(200);
+
+constexpr std::array LEVEL_NAMES{
+	"DEBUG",
+	"INFO",
+	"WARN",
+	"ERROR"
+};
+
+}
+
+
+
+Logger::Logger(const char* filePath) :
+	slots{new Slot[SLOT_COUNT]},
+	timeStart{std::chrono::steady_clock::now()},
+	file(filePath)
+{
+	static_assert((SLOT_COUNT & (SLOT_COUNT - 1)) == 0, "Slot count must be a power of two");
+	for (size_t i = 0; i < SLOT_COUNT; ++i) slots[i].sequence.store(i, std::memory_order_relaxed);
+
+	writerThread = std::jthread([this](std::stop_token stopToken) {
+		std::mutex mutex;
+		std::condition_variable_any stopSignal;
+		std::unique_lock lock(mutex);
+		while (!stopToken.stop_requested()) {
+			// Nothing notifies the condition variable, so producers never make a syscall, it only ends the wait
+			// early when a stop is requested
+			stopSignal.wait_for(lock, stopToken, WRITER_INTERVAL, [](){ return false; });
+			std::scoped_lock drainLock(drainMutex);
+			drainLocked();
+		}
+	});
+}
+
+
+
+Logger::~Logger() {
+	writerThread.request_stop();
+	if (writerThread.joinable()) writerThread.join();
+	std::scoped_lock lock(drainMutex);
+	drainLocked();
+}
+
+
+
+// Bounded multi producer ring (Vyukov), a slot is free for the producer at position p when its sequence is p, and
+// ready for the consumer once the producer publishes p + 1
+void Logger::push(LogLevel level, const char* message, size_t length) noexcept {
+	uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+	Slot* slot;
+	while (true) {
+		slot = &slots[position & (SLOT_COUNT - 1)];
+		uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+		auto difference = static_cast<int64_t>(sequence - position);
+		if (difference == 0) {
+			if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+		}
+		else if (difference < 0) {
+			droppedMessages.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else position = enqueuePosition.load(std::memory_order_relaxed);
+	}
+
+	slot->level = level;
+	slot->length = static_cast<uint8_t>(std::min(length, MAX_MESSAGE_LENGTH));
+	std::memcpy(slot->text, message, slot->length);
+	slot->timestamp = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - timeStart
+	).count());
+	slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+
+
+// Must hold drainMutex
+void Logger::drainLocked() {
+	batch.clear();
+	while (true) {
+		Slot& slot = slots[dequeuePosition & (SLOT_COUNT - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) break;
+
+		std::array<char, 48> prefix{};
+		int prefixLength = std::snprintf(
+			prefix.data(),
+			prefix.size(),
+			"[%10.3f] [%s] ",
+			static_cast<double>(slot.timestamp) / 1000.0,
+			LEVEL_NAMES[static_cast<size_t>(slot.level)]
+		);
+		batch.append(prefix.data(), static_cast<size_t>(std::max(prefixLength, 0)));
+		batch.append(slot.text, slot.length);
+		batch += '\n';
+
+		slot.sequence.store(dequeuePosition + SLOT_COUNT, std::memory_order_release);
+		dequeuePosition++;
+	}
+
+	uint64_t dropped = droppedMessages.load(std::memory_order_relaxed);
+	if (dropped != droppedMessagesReported) {
+		batch += "Logger dropped " + std::to_string(dropped - droppedMessagesReported) + " messages\n";
+		droppedMessagesReported = dropped;
+	}
+
+	if (batch.empty()) return;
+	file.write(batch.data(), static_cast<std::streamsize>(batch.size()));
 	file.flush();
 }
 
 
 
+void Logger::Write(const char* message) {
+	push(LogLevel::Info, message, std::strlen(message));
+}
+
+
+
 void Logger::Write(const std::string& message) {
-	std::lock_guard<std::mutex> lock(fileMutex);
-	file << message << "\n";
-	file.flush();
+	push(LogLevel::Info, message.data(), message.size());
+}
+
+
+
+void Logger::Write(LogLevel level, const char* message) {
+	push(level, message, std::strlen(message));
+}
+
+
+
+void Logger::Write(LogLevel level, const std::string& message) {
+	push(level, message.data(), message.size());
+}
+
+
+
+void Logger::Drain() noexcept {
+	try {
+		std::unique_lock lock(drainMutex, CRASH_DRAIN_TIMEOUT);
+		if (lock.owns_lock()) drainLocked();
+	}
+	catch (...) {}
 }
@@ -1,18 +1,75 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <fstream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 
 
 
+enum class LogLevel : uint8_t {
+	Debug,
+	Info,
+	Warning,
+	Error
+};
+
+
+
+/*
+Asynchronous logger. Writing a message copies it into a slot of a bounded lock-free ring and returns, a background
+thread drains the ring in batches and writes them to the file. If the ring is full the message is dropped and
+counted rather than blocking the caller. Messages longer than a slot are truncated.
+*/
 class Logger {
 private:
+	static constexpr size_t SLOT_COUNT = 4096;
+	static constexpr size_t MAX_MESSAGE_LENGTH = 238;
+
+	struct Slot {
+		std::atomic<uint64_t> sequence;
+		LogLevel level;
+		uint8_t length;
+		char text[MAX_MESSAGE_LENGTH];
+		uint64_t timestamp;
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	alignas(64) std::atomic<uint64_t> enqueuePosition{0};
+	alignas(64) uint64_t dequeuePosition = 0;
+	std::atomic<uint64_t> droppedMessages{0};
+	uint64_t droppedMessagesReported = 0;
+
+	std::chrono::steady_clock::time_point timeStart;
 	std::ofstream file;
-	std::mutex fileMutex;
+	// Held while draining, so that the writer thread and a crash handler never drain at the same time
+	std::timed_mutex drainMutex;
+	std::string batch;
+
+	std::jthread writerThread;
+
+private:
+	void push(LogLevel level, const char* message, size_t length) noexcept;
+	void drainLocked();
 
 public:
-	Logger(const char* filePath) : file(filePath) {};
+	Logger(const char* filePath);
+	~Logger();
+
+	Logger(Logger&&) = delete;
+	Logger(const Logger&) = delete;
+	Logger operator=(Logger&&) = delete;
+	Logger operator=(const Logger&) = delete;
 
 	void Write(const char* message);
 	void Write(const std::string& message);
+	void Write(LogLevel level, const char* message);
+	void Write(LogLevel level, const std::string& message);
+
+	// Writes out everything that has been logged so far, gives up if another thread is draining for too long
+	void Drain() noexcept;
 };
@@ -1,10 +1,10 @@
 #include "LoopGame.h"
 
-#include "GlobalLog.h"
-
+#include <chrono>
+#include <string>
 
-
-const char* NOISE_HEIGHTMAP = "FQkXCRUJDQAH@BCGZmBkAJBg@AIBEBAOamRk/C83MTD0EAg8JBg@AIBFBAOamRk/DAMAAKBBBAMAAEBBBA==";
+#include "GlobalLog.h"
+#include "Profiling/Trace.h"
 
 
 
@@ -16,7 +16,8 @@ LoopGame::LoopGame(
 ) :
 	applicationShouldTerminate{_applicationShouldTerminate},
 	sharedRendererState{std::move(_sharedRendererState)},
-	world(settings, sharedRendererState, NOISE_HEIGHTMAP),
+	debugTeleportEnabled{settings.getDebugTeleportEnabled()},
+	world(settings, sharedRendererState),
 	player(EntityPosition({ 0.0, 150.0, 0.0 }), {0.8, 3.75, 0.8}),
 	window{ _window }
 {
@@ -30,39 +31,63 @@ LoopGame::LoopGame(
 	// Get the current mouse position to avoid a larger jitter on the first frame
 	glfwGetCursorPos(window, &cursorLastX, &cursorLastY);
 
-	sharedRendererState->playerPosition.store(player.position.pos);
+	publishPlayerSnapshot(player.position);
 
-	GlobalLog.Write("Created game loop");
+	LOG_INFO("Created game loop");
 }
 
 
 void LoopGame::run() {
-	double timeFrameLast = glfwGetTime();
-	uint64_t currentTick = 0;
+	TRACE_THREAD_NAME("Game");
 
 	// Run game until ESC is pressed
 	while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS) {
-		sharedRendererState->currentTick.wait(currentTick);
-		currentTick++;
+		uint64_t currentTick = simulationClock.waitForTick();
+		EntityPosition previousPlayerPosition = player.position;
 
-		double timeFrameBegin = glfwGetTime();
-		double deltaTime = timeFrameBegin - timeFrameLast;
-		timeFrameLast = timeFrameBegin;
-
-		processInput(deltaTime);
+		processInput(SimulationClock::TICK_SECONDS);
+		// Don't interpolate the camera across a teleport
+		if (teleportedThisTick) previousPlayerPosition = player.position;
 
 		// Process the game events
-		world.tick(player);
+		world.tick(player, simulationClock);
 
-		sharedRendererState->playerPosition.store(player.position);
+		publishPlayerSnapshot(previousPlayerPosition);
+		sharedRendererState->currentTick.store(currentTick);
+		simulationClock.endTick();
 	}
 
 	applicationShouldTerminate.store(true);
+
+	const auto& statistics = simulationClock.getStatistics();
+	if (statistics.ticks) {
+		LOG_INFO(
+			"Game ticks: " + std::to_string(statistics.ticks) +
+			", dropped " + std::to_string(statistics.droppedTicks) +
+			", over budget " + std::to_string(statistics.overBudgetTicks) +
+			", mean slip " + std::to_string(statistics.totalSlip.count() / static_cast<int64_t>(statistics.ticks)) + "us" +
+			", max slip " + std::to_string(statistics.maxSlip.count()) + "us" +
+			", mean busy " + std::to_string(statistics.totalBusy.count() / static_cast<int64_t>(statistics.ticks)) + "us"
+		);
+	}
 }
 
 
 
 
+void LoopGame::publishPlayerSnapshot(const EntityPosition& previousPlayerPosition) {
+	auto tickTimestamp = simulationClock.getTickDeadline() - SimulationClock::TICK_INTERVAL;
+	sharedRendererState->playerSnapshot.store(PlayerSnapshot{
+		.previous = previousPlayerPosition,
+		.current = player.position,
+		.tickTimestamp = tickTimestamp,
+		.nextTickTimestamp = tickTimestamp + SimulationClock::TICK_INTERVAL,
+		.publishedTimestamp = std::chrono::steady_clock::now()
+	});
+}
+
+
+
 // Non-instance bound wrapper required for the glfw mouse callback
 void LoopGame::cursorPositionCallbackWrapper(GLFWwindow* window, double xpos, double ypos) {
 	LoopGame* instance = static_cast<LoopGame*>(glfwGetWindowUserPointer(window));
@@ -106,6 +131,15 @@ void LoopGame::processInput(const double deltaTime) {
 	if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) {
 		player.position.displaceVertical(-_playerSpeed);
 	}
+
+	// Debug teleport far enough that none of the loaded area is kept, only once per key press
+	constexpr double TELEPORT_DISTANCE = 4096.0;
+	bool _teleportKeyPressed = debugTeleportEnabled && glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+	teleportedThisTick = _teleportKeyPressed && !teleportKeyHeld;
+	teleportKeyHeld = _teleportKeyPressed;
+	if (teleportedThisTick) {
+		player.position.moveAbsolute(glm::dvec3(TELEPORT_DISTANCE, 0.0, 0.0));
+	}
 }
 
 
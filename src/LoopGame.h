@@ -1,5 +1,6 @@
 #pragma once
 #include "Rendering/Renderer.h"
+#include "Threading/SimulationClock.h"
 #include "World/World.h"
 class GLFWwindow;
 
@@ -9,9 +10,13 @@ class LoopGame {
 private:
 	std::atomic_bool& applicationShouldTerminate;
 	std::shared_ptr<SharedGameRendererState> sharedRendererState;
+	SimulationClock simulationClock;
 
 	double cursorLastX;
 	double cursorLastY;
+	bool debugTeleportEnabled;
+	bool teleportKeyHeld = false;
+	bool teleportedThisTick = false;
 
 	World world;
 
@@ -21,6 +26,7 @@ private:
 
 private:
 	void processInput(const double deltaTime);
+	void publishPlayerSnapshot(const EntityPosition& previousPlayerPosition);
 	void cursorPositionCallback(double xpos, double ypos);
 
 public:
@@ -0,0 +1,128 @@
+#include "FrameProfiler.h"
+
+#include <array>
+#include <cstdio>
+
+#include "../GlobalLog.h"
+
+
+
+namespace {
+
+// Enough samples for a few seconds of frames, so that the percentiles follow changes quickly
+constexpr size_t STATISTICS_WINDOW_SIZE = 512;
+
+constexpr std::array CPU_STAGE_NAMES{
+    "fence_wait",
+    "acquire",
+    "upload",
+    "chunks",
+    "gui",
+    "submit",
+    "present",
+    "frame"
+};
+constexpr std::array GPU_PASS_NAMES{
+    "upload",
+    "chunks",
+    "gui",
+    "frame"
+};
+
+}
+
+
+
+FrameProfiler::ScopedTimer::ScopedTimer(FrameProfiler& _profiler, CpuStage _stage) :
+    profiler{_profiler},
+    stage{_stage},
+    timeStart{std::chrono::steady_clock::now()}
+{}
+
+
+
+FrameProfiler::ScopedTimer::~ScopedTimer() {
+    profiler.recordCpu(stage, std::chrono::steady_clock::now() - timeStart);
+}
+
+
+
+FrameProfiler::FrameProfiler(const std::string& reportPath, double reportIntervalSeconds, bool _overlayEnabled) :
+    cpuStatistics(CPU_STAGE_COUNT, RollingStatistics(STATISTICS_WINDOW_SIZE)),
+    gpuStatistics(GPU_PASS_COUNT, RollingStatistics(STATISTICS_WINDOW_SIZE)),
+    reportFile(reportPath),
+    reportInterval{std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(reportIntervalSeconds)
+    )},
+    timeStart{std::chrono::steady_clock::now()},
+    timeLastReport{timeStart},
+    overlayEnabled{_overlayEnabled}
+{
+    static_assert(CPU_STAGE_NAMES.size() == CPU_STAGE_COUNT);
+    static_assert(GPU_PASS_NAMES.size() == GPU_PASS_COUNT);
+
+    if (!reportFile.is_open()) LOG_WARNING("Failed to open frame profile report file " + reportPath);
+    reportFile << "time,source,stage,p50_ms,p95_ms,p99_ms,samples\n";
+}
+
+
+
+void FrameProfiler::recordCpu(CpuStage stage, std::chrono::steady_clock::duration duration) {
+    cpuStatistics[static_cast<size_t>(stage)].push(
+        std::chrono::duration<double, std::milli>(duration).count()
+    );
+}
+
+
+
+void FrameProfiler::recordGpu(GpuPass pass, double milliseconds) {
+    gpuStatistics[static_cast<size_t>(pass)].push(milliseconds);
+}
+
+
+
+void FrameProfiler::endFrame() {
+    auto timeNow = std::chrono::steady_clock::now();
+    if (timeNow - timeLastReport < reportInterval) return;
+    timeLastReport = timeNow;
+    writeReport();
+}
+
+
+
+void FrameProfiler::writeReport() {
+    double time = std::chrono::duration<double>(timeLastReport - timeStart).count();
+    reportedPercentiles.clear();
+
+    auto writeRows = [&](const char* source, const auto& names, const std::vector<RollingStatistics>& statistics) {
+        for (size_t i = 0; i < statistics.size(); ++i) {
+            auto percentiles = statistics[i].getPercentiles();
+            reportedPercentiles.push_back(percentiles);
+
+            std::array<char, 128> row{};
+            std::snprintf(
+                row.data(),
+                row.size(),
+                "%.3lf,%s,%s,%.4lf,%.4lf,%.4lf,%zu\n",
+                time,
+                source,
+                names[i],
+                percentiles.p50,
+                percentiles.p95,
+                percentiles.p99,
+                statistics[i].getSampleCount()
+            );
+            reportFile << row.data();
+        }
+    };
+    writeRows("cpu", CPU_STAGE_NAMES, cpuStatistics);
+    writeRows("gpu", GPU_PASS_NAMES, gpuStatistics);
+    reportFile.flush();
+}
+
+
+
+std::span<const RollingStatistics::Percentiles> FrameProfiler::getOverlayValues() const {
+    if (!overlayEnabled) return {};
+    return reportedPercentiles;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <chrono>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "RollingStatistics.h"
+
+
+
+/*
+Collects CPU timings for each phase of a frame and GPU timings for each pass, and periodically reports rolling
+percentiles of them. Only ever used from the render thread.
+*/
+class FrameProfiler {
+public:
+    enum class CpuStage : size_t {
+        FenceWait,
+        Acquire,
+        Upload,
+        Chunks,
+        Gui,
+        Submit,
+        Present,
+        Frame,
+        COUNT
+    };
+    enum class GpuPass : size_t {
+        Upload,
+        Chunks,
+        Gui,
+        Frame,
+        COUNT
+    };
+
+    // Times the enclosing scope as a single sample of a CPU stage
+    class ScopedTimer {
+    private:
+        FrameProfiler& profiler;
+        CpuStage stage;
+        std::chrono::steady_clock::time_point timeStart;
+
+    public:
+        ScopedTimer(FrameProfiler& _profiler, CpuStage _stage);
+        ~ScopedTimer();
+
+        ScopedTimer(ScopedTimer&&) = delete;
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer operator=(ScopedTimer&&) = delete;
+        ScopedTimer operator=(const ScopedTimer&) = delete;
+    };
+
+private:
+    static constexpr size_t CPU_STAGE_COUNT = static_cast<size_t>(CpuStage::COUNT);
+    static constexpr size_t GPU_PASS_COUNT = static_cast<size_t>(GpuPass::COUNT);
+
+    std::vector<RollingStatistics> cpuStatistics;
+    std::vector<RollingStatistics> gpuStatistics;
+
+    std::ofstream reportFile;
+    std::chrono::steady_clock::duration reportInterval;
+    std::chrono::steady_clock::time_point timeStart;
+    std::chrono::steady_clock::time_point timeLastReport;
+
+    bool overlayEnabled;
+    std::vector<RollingStatistics::Percentiles> reportedPercentiles;
+
+private:
+    void writeReport();
+
+public:
+    FrameProfiler(const std::string& reportPath, double reportIntervalSeconds, bool _overlayEnabled);
+
+    FrameProfiler(FrameProfiler&&) = delete;
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler operator=(FrameProfiler&&) = delete;
+    FrameProfiler operator=(const FrameProfiler&) = delete;
+
+    void recordCpu(CpuStage stage, std::chrono::steady_clock::duration duration);
+    void recordGpu(GpuPass pass, double milliseconds);
+    // Writes out a report if the report interval has elapsed
+    void endFrame();
+
+    // The most recently reported percentiles in milliseconds, all CPU stages followed by all GPU passes, in
+    // declaration order. Empty if the overlay is disabled.
+    std::span<const RollingStatistics::Percentiles> getOverlayValues() const;
+};
@@ -0,0 +1,39 @@
+#include "RollingStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+
+RollingStatistics::RollingStatistics(size_t windowSize) : samples(windowSize) {}
+
+
+
+void RollingStatistics::push(double sample) {
+    samples[nextIndex] = sample;
+    nextIndex = (nextIndex + 1) % samples.size();
+    sampleCount = std::min(sampleCount + 1, samples.size());
+}
+
+
+
+// Uses the nearest rank method, the window is small so sorting a copy is cheap enough
+RollingStatistics::Percentiles RollingStatistics::getPercentiles() const {
+    if (!sampleCount) return {};
+
+    std::vector<double> sorted(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(sampleCount));
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&](double p) {
+        auto rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    };
+    return {
+        .p50 = percentile(0.50),
+        .p95 = percentile(0.95),
+        .p99 = percentile(0.99)
+    };
+}
+
+
+
+size_t RollingStatistics::getSampleCount() const { return sampleCount; }
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+
+
+// Keeps the most recent samples of a measurement, and computes percentiles over them
+class RollingStatistics {
+public:
+    struct Percentiles {
+        double p50{};
+        double p95{};
+        double p99{};
+    };
+
+private:
+    std::vector<double> samples;
+    size_t nextIndex = 0;
+    size_t sampleCount = 0;
+
+public:
+    RollingStatistics(size_t windowSize);
+
+    void push(double sample);
+    Percentiles getPercentiles() const;
+    size_t getSampleCount() const;
+};
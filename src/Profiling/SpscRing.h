@@ -0,0 +1,35 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+
+
+// Bounded lock-free ring buffer with a single producer thread and a single consumer thread. Pushing to a full ring
+// fails rather than blocking, so recording never stalls the producer.
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Ring capacity must be a power of two");
+
+private:
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    std::array<T, Capacity> items{};
+
+public:
+    bool push(const T& item) {
+        size_t _tail = tail.load(std::memory_order_relaxed);
+        if (_tail - head.load(std::memory_order_acquire) == Capacity) return false;
+        items[_tail & (Capacity - 1)] = item;
+        tail.store(_tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        size_t _head = head.load(std::memory_order_relaxed);
+        if (_head == tail.load(std::memory_order_acquire)) return false;
+        item = items[_head & (Capacity - 1)];
+        head.store(_head + 1, std::memory_order_release);
+        return true;
+    }
+};
@@ -0,0 +1,179 @@
+#include "Trace.h"
+
+#ifdef REVETTE_TRACING
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../GlobalLog.h"
+
+
+
+namespace Trace {
+
+namespace {
+
+// Roughly 8MB per thread, events past this are dropped
+constexpr size_t THREAD_BUFFER_CAPACITY = 1 << 18;
+
+struct Event {
+    const char* name;
+    uint64_t timestamp;
+    uint64_t id;
+    double value;
+    EventType type;
+};
+
+// Only the owning thread appends events, the count is published with release ordering so that a flush from any
+// thread can read every event before it without locking
+struct ThreadBuffer {
+    std::unique_ptr<Event[]> events{new Event[THREAD_BUFFER_CAPACITY]};
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+    uint32_t threadId;
+    std::string threadName;
+};
+
+const auto TRACE_EPOCH = std::chrono::steady_clock::now();
+
+// Buffers are never freed, so that the events of threads which have exited can still be flushed
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+ThreadBuffer* registerThread() {
+    std::scoped_lock lock(registryMutex);
+    auto& buffer = registry.emplace_back(std::make_unique<ThreadBuffer>());
+    buffer->threadId = static_cast<uint32_t>(registry.size());
+    buffer->threadName = "Thread " + std::to_string(buffer->threadId);
+    return buffer.get();
+}
+
+ThreadBuffer& getThreadBuffer() {
+    thread_local ThreadBuffer* buffer = registerThread();
+    return *buffer;
+}
+
+
+
+const char* getPhase(EventType type) {
+    switch (type) {
+    case EventType::ZoneBegin: return "B";
+    case EventType::ZoneEnd:   return "E";
+    case EventType::Counter:   return "C";
+    case EventType::FlowBegin: return "s";
+    case EventType::FlowStep:  return "t";
+    case EventType::FlowEnd:   return "f";
+    }
+    return "i";
+}
+
+}
+
+
+
+void record(EventType type, const char* name, uint64_t id, double value) {
+    ThreadBuffer& buffer = getThreadBuffer();
+    size_t index = buffer.count.load(std::memory_order_relaxed);
+    if (index == THREAD_BUFFER_CAPACITY) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - TRACE_EPOCH
+    ).count();
+    buffer.events[index] = Event{name, static_cast<uint64_t>(timestamp), id, value, type};
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+
+
+void setThreadName(const char* name) {
+    ThreadBuffer& buffer = getThreadBuffer();
+    std::scoped_lock lock(registryMutex);
+    buffer.threadName = name;
+}
+
+
+
+void flush(const char* path) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        LOG_WARNING(std::string("Failed to open trace file ") + path);
+        return;
+    }
+
+    std::scoped_lock lock(registryMutex);
+    file << "{\"traceEvents\":[\n";
+    bool first = true;
+    uint64_t dropped = 0;
+    std::array<char, 256> line{};
+    for (const auto& buffer : registry) {
+        std::snprintf(
+            line.data(),
+            line.size(),
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",\n",
+            buffer->threadId,
+            buffer->threadName.c_str()
+        );
+        file << line.data();
+        first = false;
+
+        size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            const Event& event = buffer->events[i];
+            // Timestamps are in microseconds
+            int length = std::snprintf(
+                line.data(),
+                line.size(),
+                ",\n{\"name\":\"%s\",\"cat\":\"revette\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+                event.name,
+                getPhase(event.type),
+                static_cast<double>(event.timestamp) / 1000.0,
+                buffer->threadId
+            );
+            file.write(line.data(), std::min<std::streamsize>(length, static_cast<std::streamsize>(line.size()) - 1));
+
+            switch (event.type) {
+            case EventType::Counter:
+                std::snprintf(line.data(), line.size(), ",\"args\":{\"value\":%g}}", event.value);
+                break;
+            case EventType::FlowBegin:
+            case EventType::FlowStep:
+                std::snprintf(line.data(), line.size(), ",\"id\":%llu}", static_cast<unsigned long long>(event.id));
+                break;
+            case EventType::FlowEnd:
+                // Bind to the enclosing zone rather than the next one to begin
+                std::snprintf(
+                    line.data(),
+                    line.size(),
+                    ",\"id\":%llu,\"bp\":\"e\"}",
+                    static_cast<unsigned long long>(event.id)
+                );
+                break;
+            default:
+                std::snprintf(line.data(), line.size(), "}");
+                break;
+            }
+            file << line.data();
+        }
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    file << "\n]}\n";
+
+    LOG_INFO(std::string("Wrote trace to ") + path);
+    if (dropped) LOG_INFO("Trace dropped " + std::to_string(dropped) + " events, buffers were full");
+}
+
+}
+
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+/*
+Chrome trace event format tracing, viewable in chrome://tracing or Perfetto. Everything here compiles away to
+nothing unless REVETTE_TRACING is defined (see the REVETTE_TRACING CMake option), so the macros can be left in hot
+code. Arguments to the macros are not evaluated when tracing is disabled.
+
+ - TRACE_ZONE(name) times the enclosing scope
+ - TRACE_COUNTER(name, value) records the value of a counter track
+ - TRACE_FLOW_BEGIN/STEP/END(name, id) link events on any thread that share an id, such as a chunk being generated,
+   meshed and then uploaded
+ - TRACE_THREAD_NAME(name) labels the calling thread
+ - TRACE_FLUSH(path) writes everything recorded so far to a JSON file
+
+Names must be string literals, as only the pointer is stored.
+*/
+
+#ifdef REVETTE_TRACING
+
+#include <cstdint>
+
+namespace Trace {
+
+enum class EventType : uint8_t {
+    ZoneBegin,
+    ZoneEnd,
+    Counter,
+    FlowBegin,
+    FlowStep,
+    FlowEnd
+};
+
+void record(EventType type, const char* name, uint64_t id = 0, double value = 0.0);
+void setThreadName(const char* name);
+void flush(const char* path);
+
+// Packs a chunk position into a flow id, each coordinate is wrapped to 21 bits which is far beyond any load distance
+constexpr uint64_t chunkFlowId(int32_t x, int32_t y, int32_t z) {
+    constexpr uint64_t MASK = (1ull << 21) - 1;
+    return (
+        (static_cast<uint64_t>(static_cast<uint32_t>(x)) & MASK) << 42 |
+        (static_cast<uint64_t>(static_cast<uint32_t>(y)) & MASK) << 21 |
+        (static_cast<uint64_t>(static_cast<uint32_t>(z)) & MASK)
+    );
+}
+
+class Zone {
+private:
+    const char* name;
+
+public:
+    Zone(const char* _name) : name{_name} { record(EventType::ZoneBegin, name); }
+    ~Zone() { record(EventType::ZoneEnd, name); }
+
+    Zone(Zone&&) = delete;
+    Zone(const Zone&) = delete;
+    Zone operator=(Zone&&) = delete;
+    Zone operator=(const Zone&) = delete;
+};
+
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#define TRACE_ZONE(name) ::Trace::Zone TRACE_CONCAT(traceZone, __LINE__)(name)
+#define TRACE_COUNTER(name, value) \
+    ::Trace::record(::Trace::EventType::Counter, name, 0, static_cast<double>(value))
+#define TRACE_FLOW_BEGIN(name, id) ::Trace::record(::Trace::EventType::FlowBegin, name, id)
+#define TRACE_FLOW_STEP(name, id) ::Trace::record(::Trace::EventType::FlowStep, name, id)
+#define TRACE_FLOW_END(name, id) ::Trace::record(::Trace::EventType::FlowEnd, name, id)
+#define TRACE_CHUNK_ID(pos) ::Trace::chunkFlowId((pos).getX(), (pos).getY(), (pos).getZ())
+#define TRACE_THREAD_NAME(name) ::Trace::setThreadName(name)
+#define TRACE_FLUSH(path) ::Trace::flush(path)
+
+#else
+
+#define TRACE_ZONE(name) static_cast<void>(0)
+#define TRACE_COUNTER(name, value) static_cast<void>(0)
+#define TRACE_FLOW_BEGIN(name, id) static_cast<void>(0)
+#define TRACE_FLOW_STEP(name, id) static_cast<void>(0)
+#define TRACE_FLOW_END(name, id) static_cast<void>(0)
+#define TRACE_CHUNK_ID(pos) static_cast<void>(0)
+#define TRACE_THREAD_NAME(name) static_cast<void>(0)
+#define TRACE_FLUSH(path) static_cast<void>(0)
+
+#endif
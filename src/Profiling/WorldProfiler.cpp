@@ -0,0 +1,138 @@
+#include "WorldProfiler.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+#include "../GlobalLog.h"
+
+
+
+namespace {
+
+constexpr auto EXPORT_INTERVAL = std::chrono::milliseconds(250);
+
+constexpr std::array STAGE_NAMES{
+    "mesh_unload",
+    "load_centre_change",
+    "load",
+    "populate",
+    "mesh",
+    "entities"
+};
+static_assert(STAGE_NAMES.size() == WorldProfiler::STAGE_COUNT);
+
+
+
+uint32_t microsecondsSince(std::chrono::steady_clock::time_point time) {
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - time);
+    return static_cast<uint32_t>(duration.count());
+}
+
+}
+
+
+
+WorldProfiler::WorldProfiler(const std::string& tickPath, const std::string& latencyPath) :
+    tickFile(tickPath),
+    latencyFile(latencyPath)
+{
+    if (!tickFile.is_open()) LOG_WARNING("Failed to open world tick profile file " + tickPath);
+    if (!latencyFile.is_open()) LOG_WARNING("Failed to open chunk latency profile file " + latencyPath);
+
+    tickFile << "tick,slip_us,chunk_budget_us";
+    for (auto name : STAGE_NAMES) tickFile << ',' << name << "_us," << name << "_count";
+    tickFile << ",load_queue,populate_queue,mesh_queue,mesh_upload_queue\n";
+    latencyFile << "event,x,y,z,latency_us\n";
+
+    exportThread = std::jthread([this](std::stop_token stopToken) {
+        std::mutex mutex;
+        std::condition_variable_any stopSignal;
+        std::unique_lock lock(mutex);
+        while (!stopToken.stop_requested()) {
+            // Nothing ever notifies the condition variable, it is only used to wake up early on a stop request
+            stopSignal.wait_for(lock, stopToken, EXPORT_INTERVAL, [](){ return false; });
+            if (!stopToken.stop_requested()) exportRecords();
+        }
+    });
+}
+
+
+
+WorldProfiler::~WorldProfiler() {
+    exportThread.request_stop();
+    if (exportThread.joinable()) exportThread.join();
+    exportRecords();
+
+    if (visibleCount) {
+        LOG_INFO(
+            "Chunks uploaded in view: " + std::to_string(visibleCount) +
+            ", mean time to visible " + std::to_string(visibleMicrosecondsTotal / visibleCount / 1000) + "ms" +
+            ", max " + std::to_string(visibleMicrosecondsMax / 1000) + "ms"
+        );
+    }
+
+    uint64_t dropped = droppedRecords.load();
+    if (dropped) LOG_INFO("World profiler dropped " + std::to_string(dropped) + " records");
+}
+
+
+
+// Only ever called from one thread at a time, the export thread or the destructor after it has stopped
+void WorldProfiler::exportRecords() {
+    TickRecord tickRecord;
+    while (tickRing.pop(tickRecord)) {
+        tickFile << tickRecord.tick << ',' << tickRecord.slipMicroseconds << ',' << tickRecord.chunkBudgetMicroseconds;
+        for (size_t i = 0; i < STAGE_COUNT; ++i) {
+            tickFile << ',' << tickRecord.stageMicroseconds[i] << ',' << tickRecord.itemCounts[i];
+        }
+        tickFile << ',' << tickRecord.loadQueueDepth
+            << ',' << tickRecord.populateQueueDepth
+            << ',' << tickRecord.meshQueueDepth
+            << ',' << tickRecord.meshUploadQueueDepth << '\n';
+    }
+
+    auto exportLatencies = [&](auto& ring, const char* event) {
+        LatencyRecord record;
+        while (ring.pop(record)) {
+            latencyFile << event << ',' << record.x << ',' << record.y << ',' << record.z << ','
+                << record.microseconds << '\n';
+        }
+    };
+    exportLatencies(meshedRing, "meshed");
+    exportLatencies(uploadedRing, "uploaded");
+    exportLatencies(visibleRing, "visible");
+
+    tickFile.flush();
+    latencyFile.flush();
+}
+
+
+
+void WorldProfiler::recordTick(const TickRecord& record) {
+    if (!tickRing.push(record)) droppedRecords.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+
+void WorldProfiler::recordMeshed(ChunkPos position, std::chrono::steady_clock::time_point timeRequested) {
+    LatencyRecord record{position.getX(), position.getY(), position.getZ(), microsecondsSince(timeRequested)};
+    if (!meshedRing.push(record)) droppedRecords.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+
+void WorldProfiler::recordUploaded(
+    ChunkPos position,
+    std::chrono::steady_clock::time_point timeRequested,
+    bool inView
+) {
+    LatencyRecord record{position.getX(), position.getY(), position.getZ(), microsecondsSince(timeRequested)};
+    if (!uploadedRing.push(record)) droppedRecords.fetch_add(1, std::memory_order_relaxed);
+    if (!inView) return;
+
+    if (!visibleRing.push(record)) droppedRecords.fetch_add(1, std::memory_order_relaxed);
+    visibleCount++;
+    visibleMicrosecondsTotal += record.microseconds;
+    visibleMicrosecondsMax = std::max(visibleMicrosecondsMax, record.microseconds);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "SpscRing.h"
+#include "../World/ChunkPos.h"
+
+
+
+/*
+Records per tick timings of the world pipeline, and the latency from a chunk being requested to its mesh being
+built on the game thread and uploaded on the render thread. Each producing thread has its own ring, which a
+background thread drains into CSV files.
+*/
+class WorldProfiler {
+public:
+    enum class Stage : size_t {
+        MeshUnload,
+        LoadCentreChange,
+        Load,
+        Populate,
+        Mesh,
+        Entities,
+        COUNT
+    };
+    static constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::COUNT);
+
+    struct TickRecord {
+        uint64_t tick;
+        // How late the tick started compared to the fixed schedule
+        uint32_t slipMicroseconds;
+        // Time the chunk pipeline was allowed to spend this tick
+        uint32_t chunkBudgetMicroseconds;
+        std::array<uint32_t, STAGE_COUNT> stageMicroseconds;
+        std::array<uint32_t, STAGE_COUNT> itemCounts;
+        uint32_t loadQueueDepth;
+        uint32_t populateQueueDepth;
+        uint32_t meshQueueDepth;
+        // Occupancy of the queue handing finished meshes to the renderer
+        uint32_t meshUploadQueueDepth;
+    };
+
+private:
+    struct LatencyRecord {
+        i32 x;
+        i32 y;
+        i32 z;
+        uint32_t microseconds;
+    };
+
+    // Written by the game thread
+    SpscRing<TickRecord, 4096> tickRing;
+    SpscRing<LatencyRecord, 8192> meshedRing;
+    // Written by the render thread
+    SpscRing<LatencyRecord, 8192> uploadedRing;
+    SpscRing<LatencyRecord, 8192> visibleRing;
+    // Time from a chunk being requested to it being uploaded while in view, only touched by the render thread
+    uint64_t visibleCount = 0;
+    uint64_t visibleMicrosecondsTotal = 0;
+    uint32_t visibleMicrosecondsMax = 0;
+
+    std::atomic_uint64_t droppedRecords{0};
+
+    std::ofstream tickFile;
+    std::ofstream latencyFile;
+    std::jthread exportThread;
+
+private:
+    void exportRecords();
+
+public:
+    WorldProfiler(const std::string& tickPath, const std::string& latencyPath);
+    ~WorldProfiler();
+
+    WorldProfiler(WorldProfiler&&) = delete;
+    WorldProfiler(const WorldProfiler&) = delete;
+    WorldProfiler operator=(WorldProfiler&&) = delete;
+    WorldProfiler operator=(const WorldProfiler&) = delete;
+
+    // Game thread only
+    void recordTick(const TickRecord& record);
+    void recordMeshed(ChunkPos position, std::chrono::steady_clock::time_point timeRequested);
+    // Render thread only, inView is whether the chunk was in front of the camera when it was uploaded
+    void recordUploaded(ChunkPos position, std::chrono::steady_clock::time_point timeRequested, bool inView);
+};
@@ -0,0 +1,261 @@
+#include "BakedTexture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <lodepng/lodepng.h>
+
+
+
+namespace {
+
+constexpr uint32_t BAKED_TEXTURE_MAGIC = 0x58545652; // "RVTX"
+constexpr uint32_t BAKED_TEXTURE_VERSION = 1;
+
+
+
+struct SourceFileInfo {
+    uint64_t size;
+    int64_t modifiedTime;
+};
+SourceFileInfo getSourceFileInfo(const char* path) {
+    std::error_code error;
+    auto size = std::filesystem::file_size(path, error);
+    if (error) return {0, 0};
+    auto modifiedTime = std::filesystem::last_write_time(path, error);
+    if (error) return {0, 0};
+    return {size, static_cast<int64_t>(modifiedTime.time_since_epoch().count())};
+}
+
+
+
+// Lookup table from sRGB encoded values to linear intensity, so that mips are averaged in linear space like a
+// linear blit from an sRGB image would be
+const std::array<float, 256> SRGB_TO_LINEAR = [](){
+    std::array<float, 256> table{};
+    for (size_t i = 0; i < table.size(); ++i) {
+        float value = static_cast<float>(i) / 255.0f;
+        table[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+    return table;
+}();
+
+unsigned char linearToSrgb(float value) {
+    value = std::clamp(value, 0.0f, 1.0f);
+    float encoded = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    return static_cast<unsigned char>(std::lround(encoded * 255.0f));
+}
+
+
+
+// Writes a box filtered copy of the source mip into the destination mip
+void downsample(
+    const unsigned char* source,
+    uint32_t sourceWidth,
+    uint32_t sourceHeight,
+    unsigned char* destination,
+    uint32_t destinationWidth,
+    uint32_t destinationHeight
+) {
+    for (uint32_t y = 0; y < destinationHeight; ++y) {
+        for (uint32_t x = 0; x < destinationWidth; ++x) {
+            uint32_t x0 = std::min(x * 2, sourceWidth - 1);
+            uint32_t x1 = std::min(x * 2 + 1, sourceWidth - 1);
+            uint32_t y0 = std::min(y * 2, sourceHeight - 1);
+            uint32_t y1 = std::min(y * 2 + 1, sourceHeight - 1);
+            std::array<const unsigned char*, 4> texels{
+                source + (y0 * sourceWidth + x0) * 4,
+                source + (y0 * sourceWidth + x1) * 4,
+                source + (y1 * sourceWidth + x0) * 4,
+                source + (y1 * sourceWidth + x1) * 4
+            };
+
+            unsigned char* target = destination + (y * destinationWidth + x) * 4;
+            for (size_t channel = 0; channel < 3; ++channel) {
+                float sum = 0.0f;
+                for (auto texel : texels) sum += SRGB_TO_LINEAR[texel[channel]];
+                target[channel] = linearToSrgb(sum * 0.25f);
+            }
+            unsigned alphaSum = 0;
+            for (auto texel : texels) alphaSum += texel[3];
+            target[3] = static_cast<unsigned char>((alphaSum + 2) / 4);
+        }
+    }
+}
+
+}
+
+
+
+uint32_t getMipWidth(const BakedTextureHeader& header, uint32_t level) {
+    return std::max(header.cellWidth >> level, 1u);
+}
+
+
+
+uint32_t getMipHeight(const BakedTextureHeader& header, uint32_t level) {
+    return std::max(header.cellHeight >> level, 1u);
+}
+
+
+
+uint64_t getMipLevelOffset(const BakedTextureHeader& header, uint32_t level) {
+    uint64_t offset = 0;
+    for (uint32_t i = 0; i < level; ++i) {
+        offset += uint64_t{getMipWidth(header, i)} * getMipHeight(header, i) * header.layerCount * 4;
+    }
+    return offset;
+}
+
+
+
+BakedTexture bakeTexture(const TextureSource& source) {
+    SourceFileInfo sourceInfo = getSourceFileInfo(source.sourcePath);
+
+    std::vector<unsigned char> imageData;
+    unsigned width;
+    unsigned height;
+    if (lodepng::decode(imageData, width, height, source.sourcePath)) {
+        throw std::runtime_error("Failed to read texture data");
+    }
+
+    // Error if the texture isn't a grid of cell sized rectangles
+    if (width % source.cellWidth != 0 || height % source.cellHeight != 0) {
+        throw std::runtime_error("Invalid texture size");
+    }
+    uint32_t textureGridWidth = width / source.cellWidth;
+    uint32_t textureGridHeight = height / source.cellHeight;
+
+    BakedTexture texture{
+        .header{
+            .magic = BAKED_TEXTURE_MAGIC,
+            .version = BAKED_TEXTURE_VERSION,
+            .cellWidth = source.cellWidth,
+            .cellHeight = source.cellHeight,
+            .layerCount = textureGridWidth * textureGridHeight,
+            .mipLevelCount = source.mipLevelCount,
+            .sourceSize = sourceInfo.size,
+            .sourceModifiedTime = sourceInfo.modifiedTime,
+            .dataSize{}
+        },
+        .data{}
+    };
+    const BakedTextureHeader& header = texture.header;
+    texture.header.dataSize = getMipLevelOffset(header, header.mipLevelCount);
+    texture.data.resize(texture.header.dataSize);
+
+    // Each layer only writes its own region of every mip level, so the layers can be processed independently
+    auto bakeLayer = [&](uint32_t layer) {
+        uint32_t row = layer / textureGridWidth;
+        uint32_t col = layer % textureGridWidth;
+        uint64_t cellBytes = uint64_t{header.cellWidth} * header.cellHeight * 4;
+        unsigned char* cell = texture.data.data() + cellBytes * layer;
+        for (uint32_t y = 0; y < header.cellHeight; ++y) {
+            const unsigned char* sourceRow = imageData.data() +
+                ((uint64_t{row} * header.cellHeight + y) * width + uint64_t{col} * header.cellWidth) * 4;
+            std::memcpy(cell + uint64_t{y} * header.cellWidth * 4, sourceRow, header.cellWidth * 4);
+        }
+
+        for (uint32_t level = 1; level < header.mipLevelCount; ++level) {
+            uint32_t sourceWidth = getMipWidth(header, level - 1);
+            uint32_t sourceHeight = getMipHeight(header, level - 1);
+            uint32_t mipWidth = getMipWidth(header, level);
+            uint32_t mipHeight = getMipHeight(header, level);
+            const unsigned char* sourceMip = texture.data.data() + getMipLevelOffset(header, level - 1) +
+                uint64_t{sourceWidth} * sourceHeight * 4 * layer;
+            unsigned char* mip = texture.data.data() + getMipLevelOffset(header, level) +
+                uint64_t{mipWidth} * mipHeight * 4 * layer;
+            downsample(sourceMip, sourceWidth, sourceHeight, mip, mipWidth, mipHeight);
+        }
+    };
+
+    uint32_t threadCount = std::clamp(std::thread::hardware_concurrency(), 1u, header.layerCount);
+    std::vector<std::jthread> workers;
+    workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back([&, i](){
+            for (uint32_t layer = i; layer < header.layerCount; layer += threadCount) bakeLayer(layer);
+        });
+    }
+    workers.clear();
+
+    return texture;
+}
+
+
+
+// The texture is written to a temporary file first, so that a partially written file is never picked up
+void writeBakedTexture(const char* path, const BakedTexture& texture) {
+    std::string temporaryPath = std::string(path) + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) throw std::runtime_error("Failed to open baked texture file for writing");
+        file.write(reinterpret_cast<const char*>(&texture.header), sizeof(texture.header));
+        file.write(reinterpret_cast<const char*>(texture.data.data()), static_cast<std::streamsize>(texture.data.size()));
+        if (!file) throw std::runtime_error("Failed to write baked texture file");
+    }
+    if (std::rename(temporaryPath.c_str(), path) != 0) {
+        throw std::runtime_error("Failed to rename baked texture file");
+    }
+}
+
+
+
+BakedTextureFile::BakedTextureFile(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return;
+
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) == 0 && static_cast<size_t>(fileStat.st_size) >= sizeof(BakedTextureHeader)) {
+        void* result = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (result != MAP_FAILED) {
+            mapping = static_cast<const unsigned char*>(result);
+            mappingSize = static_cast<uint64_t>(fileStat.st_size);
+            std::memcpy(&header, mapping, sizeof(header));
+        }
+    }
+    // The mapping remains valid after the descriptor is closed
+    close(fd);
+}
+
+
+
+BakedTextureFile::~BakedTextureFile() {
+    if (mapping) munmap(const_cast<unsigned char*>(mapping), mappingSize);
+}
+
+
+
+bool BakedTextureFile::isCurrent(const TextureSource& source) const {
+    if (!mapping) return false;
+
+    SourceFileInfo sourceInfo = getSourceFileInfo(source.sourcePath);
+    return (
+        header.magic == BAKED_TEXTURE_MAGIC &&
+        header.version == BAKED_TEXTURE_VERSION &&
+        header.cellWidth == source.cellWidth &&
+        header.cellHeight == source.cellHeight &&
+        header.mipLevelCount == source.mipLevelCount &&
+        header.sourceSize == sourceInfo.size &&
+        header.sourceModifiedTime == sourceInfo.modifiedTime &&
+        header.dataSize == getMipLevelOffset(header, header.mipLevelCount) &&
+        mappingSize - sizeof(BakedTextureHeader) == header.dataSize
+    );
+}
+
+
+
+const BakedTextureHeader& BakedTextureFile::getHeader() const { return header; }
+const unsigned char* BakedTextureFile::getData() const { return mapping + sizeof(BakedTextureHeader); }
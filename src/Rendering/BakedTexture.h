@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+
+// A texture atlas which is sliced into an array of equally sized cells
+struct TextureSource {
+    const char* sourcePath;
+    const char* bakedPath;
+    uint32_t cellWidth;
+    uint32_t cellHeight;
+    uint32_t mipLevelCount;
+};
+constexpr std::array TEXTURE_SOURCES{
+    TextureSource{"res/textures/texture_atlas.png", "res/textures/texture_atlas.rvtex", 16u, 16u, 4u},
+    TextureSource{"res/textures/character_set.png", "res/textures/character_set.rvtex", 6u,  8u,  1u}
+};
+
+
+
+/*
+Baked textures store RGBA8 sRGB pixel data for every array layer and mip level, laid out so that each mip level can
+be copied with a single vkCmdCopyBufferToImage region. Mip levels are stored in order, and within a level the layers
+are stored contiguously. The size and modification time of the source image are kept so that stale files can be
+detected.
+*/
+struct BakedTextureHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t cellWidth;
+    uint32_t cellHeight;
+    uint32_t layerCount;
+    uint32_t mipLevelCount;
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+    uint64_t dataSize;
+};
+
+uint32_t getMipWidth(const BakedTextureHeader& header, uint32_t level);
+uint32_t getMipHeight(const BakedTextureHeader& header, uint32_t level);
+uint64_t getMipLevelOffset(const BakedTextureHeader& header, uint32_t level);
+
+
+
+struct BakedTexture {
+    BakedTextureHeader header;
+    std::vector<unsigned char> data;
+};
+
+// Decodes the source image and generates all mip levels, layers are processed in parallel
+BakedTexture bakeTexture(const TextureSource& source);
+void writeBakedTexture(const char* path, const BakedTexture& texture);
+
+
+
+// Read only memory mapping of a baked texture file
+class BakedTextureFile {
+private:
+    const unsigned char* mapping{};
+    uint64_t mappingSize{};
+    BakedTextureHeader header{};
+
+public:
+    BakedTextureFile(const char* path);
+    ~BakedTextureFile();
+
+    BakedTextureFile(BakedTextureFile&&) = delete;
+    BakedTextureFile(const BakedTextureFile&) = delete;
+    BakedTextureFile operator=(BakedTextureFile&&) = delete;
+    BakedTextureFile operator=(const BakedTextureFile&) = delete;
+
+    // Whether the file exists, is well formed, and was baked from the current version of the source
+    bool isCurrent(const TextureSource& source) const;
+
+    const BakedTextureHeader& getHeader() const;
+    const unsigned char* getData() const;
+};
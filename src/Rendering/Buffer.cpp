@@ -43,6 +43,7 @@ Buffer::Buffer(
         throw std::runtime_error("Failed to allocate vertex buffer");
     }
     mapping = allocInfo.pMappedData;
+    vmaGetAllocationMemoryProperties(allocator, allocation, &memoryProperties);
 }
 
 
@@ -51,7 +52,8 @@ Buffer::Buffer(Buffer&& other) :
     allocator{std::exchange(other.allocator, nullptr)},
     allocation{other.allocation},
     buffer{other.buffer},
-    mapping{other.mapping}
+    mapping{other.mapping},
+    memoryProperties{other.memoryProperties}
 {}
 
 
@@ -64,6 +66,15 @@ Buffer::~Buffer() {
 
 
 
+// Makes host writes to the mapping visible to the device, this is a no-op for host coherent memory
+void Buffer::flush(VkDeviceSize offset, VkDeviceSize size) const {
+    if (vmaFlushAllocation(allocator, allocation, offset, size) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to flush buffer allocation");
+    }
+}
+
+
+
 // This function must only be called if the buffer was created as mapped
 void* Buffer::getMappedPointer() const {
     if (!mapping) {
@@ -78,3 +89,14 @@ VkBuffer Buffer::getHandle() const {
     return buffer;
 }
 
+
+
+VkMemoryPropertyFlags Buffer::getMemoryProperties() const {
+    return memoryProperties;
+}
+
+
+
+bool Buffer::isMapped() const {
+    return mapping != nullptr;
+}
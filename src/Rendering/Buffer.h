@@ -9,6 +9,7 @@ private:
     VmaAllocation allocation{};
     VkBuffer buffer{};
     void* mapping{};
+    VkMemoryPropertyFlags memoryProperties{};
 
 public:
     Buffer(
@@ -27,6 +28,9 @@ public:
     Buffer operator=(Buffer&&) = delete;
     Buffer operator=(const Buffer&) = delete;
 
+    void flush(VkDeviceSize offset, VkDeviceSize size) const;
     void* getMappedPointer() const;
     VkBuffer getHandle() const;
+    VkMemoryPropertyFlags getMemoryProperties() const;
+    bool isMapped() const;
 };
@@ -1,5 +1,7 @@
 #include "ChunkRenderer.h"
 
+#include <exception>
+#include <future>
 #include <stdexcept>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -12,6 +14,7 @@ namespace {
 
 VkPipeline createPipeline(
     VkDevice device,
+    VkPipelineCache pipelineCache,
     const RenderTarget& renderTarget,
     VkPipelineLayout layout,
     const char* shaderPath,
@@ -171,7 +174,7 @@ VkPipeline createPipeline(
     };
     
     VkPipeline pipeline;
-    VkResult result = vkCreateGraphicsPipelines(device, {}, 1, &createInfo, nullptr, &pipeline);
+    VkResult result = vkCreateGraphicsPipelines(device, pipelineCache, 1, &createInfo, nullptr, &pipeline);
     // Destroy the shader module regardless of whether the pipeline was successfully created
     vkDestroyShaderModule(device, shaderModule, nullptr);
     if (result != VK_SUCCESS) {
@@ -184,7 +187,7 @@ VkPipeline createPipeline(
 
 
 
-void ChunkRenderer::createPipelines(const RenderTarget& renderTarget) {
+void ChunkRenderer::createPipelines(const RenderTarget& renderTarget, VkPipelineCache pipelineCache) {
     VkPipelineColorBlendAttachmentState colourBlendNone{
         .blendEnable{},
         .srcColorBlendFactor{},
@@ -214,30 +217,55 @@ void ChunkRenderer::createPipelines(const RenderTarget& renderTarget) {
             VK_COLOR_COMPONENT_A_BIT
     };
 
-    pipelineOpaque = createPipeline(
+    // Each pipeline is created on its own thread, the pipeline cache is internally synchronised
+    auto futureOpaque = std::async(
+        std::launch::async,
+        createPipeline,
         device,
-        renderTarget,
+        pipelineCache,
+        std::cref(renderTarget),
         pipelineLayout,
         "res/shaders/chunk_opaque.spv",
         VK_CULL_MODE_BACK_BIT,
-        colourBlendNone
+        std::ref(colourBlendNone)
     );
-    pipelineTested = createPipeline(
+    auto futureTested = std::async(
+        std::launch::async,
+        createPipeline,
         device,
-        renderTarget,
+        pipelineCache,
+        std::cref(renderTarget),
         pipelineLayout,
         "res/shaders/chunk_tested.spv",
         VK_CULL_MODE_NONE,
-        colourBlendNone
+        std::ref(colourBlendNone)
     );
-    pipelineBlended = createPipeline(
+    auto futureBlended = std::async(
+        std::launch::async,
+        createPipeline,
         device,
-        renderTarget,
+        pipelineCache,
+        std::cref(renderTarget),
         pipelineLayout,
         "res/shaders/chunk_blended.spv",
         VK_CULL_MODE_NONE,
-        colourBlendAlpha
+        std::ref(colourBlendAlpha)
     );
+
+    // Every result is collected before an error is rethrown, so the pipelines created by the other threads don't leak
+    std::exception_ptr error;
+    auto collect = [&error](std::future<VkPipeline>& future, VkPipeline& pipeline) {
+        try {
+            pipeline = future.get();
+        }
+        catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    };
+    collect(futureOpaque, pipelineOpaque);
+    collect(futureTested, pipelineTested);
+    collect(futureBlended, pipelineBlended);
+    if (error) std::rethrow_exception(error);
 }
 
 
@@ -266,13 +294,11 @@ void ChunkRenderer::createLayout(VkDescriptorSetLayout setLayout) {
 
 ChunkRenderer::ChunkRenderer(
     VkDevice _device,
-    const RenderTarget& renderTarget,
     VkDescriptorSetLayout setLayout
 ) : ChunkRenderer() {
     device = _device;
 
     createLayout(setLayout);
-    createPipelines(renderTarget);
 }
 
 
@@ -19,16 +19,18 @@ private:
     ChunkRenderer() = default;
 
     void createLayout(VkDescriptorSetLayout setLayout);
-    void createPipelines(const RenderTarget& renderTarget);
     
 public:
     ChunkRenderer(
         VkDevice _device,
-        const RenderTarget& renderTarget,
         VkDescriptorSetLayout setLayout
     );
     ~ChunkRenderer();
 
+    // Called once after construction, so that the pipelines of all the renderers can be created at the same time.
+    // Pipelines which were created are destroyed with the renderer even if creating another one failed.
+    void createPipelines(const RenderTarget& renderTarget, VkPipelineCache pipelineCache);
+
     void draw(
         VkCommandBuffer commandBuffer,
         const glm::mat4& matrixProjectionView,
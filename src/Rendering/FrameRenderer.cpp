@@ -1,17 +1,48 @@
 #include "FrameRenderer.h"
 
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <stdexcept>
 #include <utility>
 
+#include <glm/geometric.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "Vulkan_Utils.h"
+#include "../Profiling/Trace.h"
 
 
 
 namespace {
 
+// A cone around the view direction, 40 degrees either side which is slightly wider than the horizontal field of view
+constexpr double VIEW_CONE_HALF_ANGLE = 0.6981317;
+// Radius of a sphere enclosing a chunk
+constexpr double CHUNK_BOUNDING_RADIUS = CHUNK_SIZE_D * 0.8660254;
+
+
+
+// Whether any part of the chunk could be on screen, only used for profiling so it is deliberately loose
+bool chunkInView(ChunkPos pos, const EntityPosition& playerPosition) {
+    const glm::dvec3 chunkCentre = (glm::dvec3(pos.getX(), pos.getY(), pos.getZ()) + 0.5) * CHUNK_SIZE_D;
+    const glm::dvec3 offset = chunkCentre - playerPosition.pos;
+    double distance = glm::length(offset);
+    if (distance <= CHUNK_BOUNDING_RADIUS) return true;
+
+    double rotationY = glm::radians(std::clamp(playerPosition.yRotation, -89.9, 89.9));
+    double rotationX = glm::radians(playerPosition.xRotation);
+    const glm::dvec3 front(
+        std::cos(rotationX) * std::cos(rotationY),
+        std::sin(rotationY),
+        std::sin(rotationX) * std::cos(rotationY)
+    );
+    double angle = std::acos(std::clamp(glm::dot(offset / distance, front), -1.0, 1.0));
+    return angle <= VIEW_CONE_HALF_ANGLE + std::asin(CHUNK_BOUNDING_RADIUS / distance);
+}
+
+
+
 VkSemaphore createSemaphore(VkDevice device) {
     VkSemaphoreCreateInfo createInfo{
         .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
@@ -26,6 +57,28 @@ VkSemaphore createSemaphore(VkDevice device) {
     return semaphore;
 }
 
+
+
+// Written at the start of the frame, after the uploads, after the chunks, and after the GUI
+constexpr uint32_t TIMESTAMP_COUNT = 4;
+
+VkQueryPool createTimestampQueryPool(VkDevice device) {
+    VkQueryPoolCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext{},
+        .flags{},
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = TIMESTAMP_COUNT,
+        .pipelineStatistics{}
+    };
+
+    VkQueryPool queryPool;
+    if (vkCreateQueryPool(device, &createInfo, nullptr, &queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create timestamp query pool");
+    }
+    return queryPool;
+}
+
 }
 
 
@@ -39,24 +92,34 @@ This function prepares all objects to be ready to render the next frame. It does
 */
 uint32_t FrameRenderer::beginFrame(
     std::queue<std::unique_ptr<MeshChunk::Data>> loadMeshes,
-    std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes
+    const EntityPosition& playerPosition,
+    std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes,
+    MeshChunk::BufferCache& meshBufferCache
 ) {
+    TRACE_ZONE("FrameRenderer::beginFrame");
     // Wait until the previous frame using these resources has completed
     VkFence fence = fenceBegin.get();
-    if (vkWaitForFences(device, 1, &fence, {}, UINT64_MAX) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to wait for fences");
+    {
+        FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::CpuStage::FenceWait);
+        if (vkWaitForFences(device, 1, &fence, {}, UINT64_MAX) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to wait for fences");
+        }
     }
+    readTimestamps();
 
     uint32_t imageIndex{};
-    if (vkAcquireNextImageKHR(
-        device,
-        renderTarget.getSwapchain(),
-        UINT64_MAX,
-        semaphoreImageAvailable,
-        {},
-        &imageIndex
-    ) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to acquire next swapchain image");
+    {
+        FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::CpuStage::Acquire);
+        if (vkAcquireNextImageKHR(
+            device,
+            renderTarget.getSwapchain(),
+            UINT64_MAX,
+            semaphoreImageAvailable,
+            {},
+            &imageIndex
+        ) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to acquire next swapchain image");
+        }
     }
 
     if (vkResetFences(device, 1, &fence) != VK_SUCCESS) {
@@ -65,6 +128,10 @@ uint32_t FrameRenderer::beginFrame(
 
     // Reset and start new command buffer
     commandBuffer.reset();
+    if (queryPool) {
+        vkCmdResetQueryPool(commandBuffer.getBuffer(), queryPool, 0, TIMESTAMP_COUNT);
+        writeTimestamp(0, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT);
+    }
 
     std::vector<VkBufferMemoryBarrier2> bufferBarriers;
     std::vector<VkImageMemoryBarrier2> imageBarriers;
@@ -115,7 +182,7 @@ uint32_t FrameRenderer::beginFrame(
     );
 
     // Upload new meshes
-    uploadMeshes(bufferBarriers, std::move(loadMeshes), chunkMeshes);
+    uploadMeshes(bufferBarriers, std::move(loadMeshes), playerPosition, chunkMeshes, meshBufferCache);
 
     // Barrier for image transitions and mesh uploading
     VkDependencyInfo dependencyInfo{
@@ -130,6 +197,7 @@ uint32_t FrameRenderer::beginFrame(
         .pImageMemoryBarriers = imageBarriers.data()
     };
     vkCmdPipelineBarrier2(commandBuffer.getBuffer(), &dependencyInfo);
+    writeTimestamp(1, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
 
     VkRenderingAttachmentInfo attachmentColour{
         .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
@@ -187,23 +255,38 @@ uint32_t FrameRenderer::beginFrame(
 void FrameRenderer::uploadMeshes(
     std::vector<VkBufferMemoryBarrier2>& bufferBarriers,
     std::queue<std::unique_ptr<MeshChunk::Data>> loadMeshes,
-    std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes
+    const EntityPosition& playerPosition,
+    std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes,
+    MeshChunk::BufferCache& meshBufferCache
 ) {
+    TRACE_ZONE("FrameRenderer::uploadMeshes");
+    FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::CpuStage::Upload);
     stagingBuffer.reset();
 
     while (loadMeshes.size()) {
         ChunkPos pos = loadMeshes.front()->getPosition();
-        bufferBarriers.push_back({});
-        chunkMeshes.insert({
-            pos,
-            std::make_unique<MeshChunk>(
-                bufferBarriers.back(),
-                std::move(loadMeshes.front()),
-                allocator,
-                commandBuffer.getBuffer(),
-                stagingBuffer
-            )
-        });
+        worldProfiler.recordUploaded(pos, loadMeshes.front()->getTimeRequested(), chunkInView(pos, playerPosition));
+        auto mesh = std::make_unique<MeshChunk>(
+            bufferBarriers,
+            std::move(loadMeshes.front()),
+            allocator,
+            commandBuffer.getBuffer(),
+            stagingBuffer,
+            meshBufferCache
+        );
+        switch (mesh->getUploadPath()) {
+        case MeshChunk::UploadPath::Direct:
+            uploadCounts.direct++;
+            break;
+        case MeshChunk::UploadPath::Staged:
+            uploadCounts.staged++;
+            break;
+        case MeshChunk::UploadPath::Shared:
+            uploadCounts.shared++;
+            uploadCounts.sharedBytes += mesh->getBufferSize();
+            break;
+        }
+        chunkMeshes.insert({pos, std::move(mesh)});
         loadMeshes.pop();
     }
 }
@@ -214,6 +297,8 @@ void FrameRenderer::drawChunks(
     EntityPosition playerPos,
     std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes
 ) {
+    TRACE_ZONE("FrameRenderer::drawChunks");
+    FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::CpuStage::Chunks);
     double rotationY = glm::radians(std::clamp(playerPos.yRotation, -89.9, 89.9));
     double rotationX = glm::radians(playerPos.xRotation);
     glm::mat4 projection = glm::perspective(glm::radians(45.0), 1920.0 / 1080.0, 0.25, 1024.0);
@@ -246,7 +331,9 @@ void FrameRenderer::drawChunks(
 This function submits all the rendering commands to the GPU, and submits the frame for presentation to the screen.
 */
 void FrameRenderer::endFrame(uint32_t imageIndex) {
+    TRACE_ZONE("FrameRenderer::endFrame");
     vkCmdEndRendering(commandBuffer.getBuffer());
+    writeTimestamp(3, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
 
     // Transition the image to the presentation format (mostly likely a no-op)
     addPipelineImageBarrier(
@@ -291,9 +378,13 @@ void FrameRenderer::endFrame(uint32_t imageIndex) {
         .signalSemaphoreCount = 1,
         .pSignalSemaphores = &semaphorePresent
     };
-    if (vkQueueSubmit(queue, 1, &submitInfo, fenceBegin.get()) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to submit draw commands to queue");
+    {
+        FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::CpuStage::Submit);
+        if (vkQueueSubmit(queue, 1, &submitInfo, fenceBegin.get()) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit draw commands to queue");
+        }
     }
+    timestampsWritten = static_cast<bool>(queryPool);
 
     VkResult presentResult{};
     VkSwapchainKHR swapchain = renderTarget.getSwapchain();
@@ -307,6 +398,7 @@ void FrameRenderer::endFrame(uint32_t imageIndex) {
         .pImageIndices = &imageIndex,
         .pResults = &presentResult
     };
+    FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::CpuStage::Present);
     if (vkQueuePresentKHR(queue, &presentInfo) != VK_SUCCESS) {
         throw std::runtime_error("Failed to submit presentation to queue");
     }
@@ -323,6 +415,8 @@ FrameRenderer::FrameRenderer(
     RenderResources& _renderResources,
     ChunkRenderer& _chunkRenderer,
     GuiRenderer& _guiRenderer,
+    FrameProfiler& _profiler,
+    WorldProfiler& _worldProfiler,
     uint32_t queueFamilyIndex,
     VmaAllocator _allocator
 ) :
@@ -332,6 +426,8 @@ FrameRenderer::FrameRenderer(
     renderResources{_renderResources},
     chunkRenderer{_chunkRenderer},
     guiRenderer{_guiRenderer},
+    profiler{_profiler},
+    worldProfiler{_worldProfiler},
     // 8MB should be good, probably?
     stagingBuffer(
         allocator,
@@ -352,21 +448,28 @@ FrameRenderer::FrameRenderer(
     RenderResources& _renderResources,
     ChunkRenderer& _chunkRenderer,
     GuiRenderer& _guiRenderer,
+    FrameProfiler& _profiler,
+    WorldProfiler& _worldProfiler,
     uint32_t queueFamilyIndex,
-    VmaAllocator allocator
+    VmaAllocator allocator,
+    float _timestampPeriod
 ) : FrameRenderer(
     _device,
     _renderTarget,
     _renderResources,
     _chunkRenderer,
     _guiRenderer,
+    _profiler,
+    _worldProfiler,
     queueFamilyIndex,
     allocator
 ) {
     queue = _queue;
+    timestampPeriod = _timestampPeriod;
 
     semaphoreImageAvailable = createSemaphore(device);
     semaphorePresent = createSemaphore(device);
+    if (timestampPeriod > 0.0f) queryPool = createTimestampQueryPool(device);
 }
 
 
@@ -376,6 +479,7 @@ FrameRenderer::~FrameRenderer() {
     // (I fucking hate this language)
     if (!device) return;
 
+    vkDestroyQueryPool(device, queryPool, nullptr);
     vkDestroySemaphore(device, semaphorePresent, nullptr);
     vkDestroySemaphore(device, semaphoreImageAvailable, nullptr);
 }
@@ -390,11 +494,17 @@ FrameRenderer::FrameRenderer(FrameRenderer&& old) :
     renderResources{old.renderResources},
     chunkRenderer{old.chunkRenderer},
     guiRenderer{old.guiRenderer},
+    profiler{old.profiler},
+    worldProfiler{old.worldProfiler},
     stagingBuffer{std::move(old.stagingBuffer)},
     commandBuffer{std::move(old.commandBuffer)},
     fenceBegin{std::move(old.fenceBegin)},
     semaphoreImageAvailable{old.semaphoreImageAvailable},
-    semaphorePresent{old.semaphorePresent}
+    semaphorePresent{old.semaphorePresent},
+    queryPool{old.queryPool},
+    timestampPeriod{old.timestampPeriod},
+    timestampsWritten{old.timestampsWritten},
+    uploadCounts{old.uploadCounts}
 {}
 
 
@@ -402,9 +512,12 @@ FrameRenderer::FrameRenderer(FrameRenderer&& old) :
 void FrameRenderer::drawFrame(
     std::queue<std::unique_ptr<MeshChunk::Data>> loadMeshes,
     EntityPosition playerPosition,
-    std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes
+    float loadingProgress,
+    std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes,
+    MeshChunk::BufferCache& meshBufferCache
 ) {
-    uint32_t imageIndex = beginFrame(std::move(loadMeshes), chunkMeshes);
+    TRACE_ZONE("FrameRenderer::drawFrame");
+    uint32_t imageIndex = beginFrame(std::move(loadMeshes), playerPosition, chunkMeshes, meshBufferCache);
     
     // Delete the whole queue
     meshDeletionQueue = std::queue<std::unique_ptr<MeshChunk>>();
@@ -438,23 +551,29 @@ void FrameRenderer::drawFrame(
     );
 
     drawChunks(playerPosition, chunkMeshes);
-
-    vkCmdBindDescriptorSets(
-        commandBuffer.getBuffer(),
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        guiRenderer.getLayout(),
-        0,
-        1,
-        &descriptorSet,
-        0,
-        {}
-    );
-    guiRenderer.draw(
-        commandBuffer.getBuffer(),
-        renderTarget.getExtext(),
-        stagingBuffer,
-        playerPosition
-    );
+    writeTimestamp(2, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+
+    {
+        FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::CpuStage::Gui);
+        vkCmdBindDescriptorSets(
+            commandBuffer.getBuffer(),
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            guiRenderer.getLayout(),
+            0,
+            1,
+            &descriptorSet,
+            0,
+            {}
+        );
+        guiRenderer.draw(
+            commandBuffer.getBuffer(),
+            renderTarget.getExtext(),
+            stagingBuffer,
+            playerPosition,
+            loadingProgress,
+            profiler.getOverlayValues()
+        );
+    }
 
     endFrame(imageIndex);
 }
@@ -464,3 +583,43 @@ void FrameRenderer::drawFrame(
 void FrameRenderer::queueMeshForDeletion(std::unique_ptr<MeshChunk> mesh) {
     meshDeletionQueue.push(std::move(mesh));
 }
+
+
+
+// Reads back the timestamps of the last frame that used these resources, which must have completed
+void FrameRenderer::readTimestamps() {
+    if (!timestampsWritten) return;
+    timestampsWritten = false;
+
+    std::array<uint64_t, TIMESTAMP_COUNT> timestamps{};
+    if (vkGetQueryPoolResults(
+        device,
+        queryPool,
+        0,
+        TIMESTAMP_COUNT,
+        sizeof(timestamps),
+        timestamps.data(),
+        sizeof(uint64_t),
+        VK_QUERY_RESULT_64_BIT
+    ) != VK_SUCCESS) return;
+
+    auto toMilliseconds = [&](uint64_t begin, uint64_t end) {
+        return static_cast<double>(end - begin) * static_cast<double>(timestampPeriod) * 1e-6;
+    };
+    profiler.recordGpu(FrameProfiler::GpuPass::Upload, toMilliseconds(timestamps[0], timestamps[1]));
+    profiler.recordGpu(FrameProfiler::GpuPass::Chunks, toMilliseconds(timestamps[1], timestamps[2]));
+    profiler.recordGpu(FrameProfiler::GpuPass::Gui, toMilliseconds(timestamps[2], timestamps[3]));
+    profiler.recordGpu(FrameProfiler::GpuPass::Frame, toMilliseconds(timestamps[0], timestamps[3]));
+}
+
+
+
+void FrameRenderer::writeTimestamp(uint32_t query, VkPipelineStageFlags2 stage) {
+    if (queryPool) vkCmdWriteTimestamp2(commandBuffer.getBuffer(), stage, queryPool, query);
+}
+
+
+
+FrameRenderer::MeshUploadCounts FrameRenderer::getMeshUploadCounts() const {
+    return uploadCounts;
+}
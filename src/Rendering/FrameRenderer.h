@@ -9,10 +9,22 @@
 #include "RenderResources.h"
 #include "RenderTarget.h"
 #include "SingleCommandBuffer.h"
+#include "../Profiling/FrameProfiler.h"
+#include "../Profiling/WorldProfiler.h"
 
 
 
 class FrameRenderer {
+public:
+    // Number of chunk meshes uploaded through each path, see MeshChunk::UploadPath
+    struct MeshUploadCounts {
+        uint64_t direct{};
+        uint64_t staged{};
+        uint64_t shared{};
+        // Buffer memory that shared meshes would otherwise have allocated
+        uint64_t sharedBytes{};
+    };
+
 private:
     VkDevice device;
     VkQueue queue;
@@ -21,6 +33,8 @@ private:
     RenderResources& renderResources;
     ChunkRenderer& chunkRenderer;
     GuiRenderer& guiRenderer;
+    FrameProfiler& profiler;
+    WorldProfiler& worldProfiler;
 
     LinearBufferSuballocator stagingBuffer;
     SingleCommandBuffer commandBuffer;
@@ -29,8 +43,15 @@ private:
     VkSemaphore semaphoreImageAvailable{};
     VkSemaphore semaphorePresent{};
 
+    // Null if the queue doesn't support timestamps
+    VkQueryPool queryPool{};
+    float timestampPeriod{};
+    bool timestampsWritten = false;
+
     std::queue<std::unique_ptr<MeshChunk>> meshDeletionQueue;
 
+    MeshUploadCounts uploadCounts;
+
 private:
     FrameRenderer(
         VkDevice _device,
@@ -38,24 +59,32 @@ private:
         RenderResources& _renderResources,
         ChunkRenderer& _chunkRenderer,
         GuiRenderer& _guiRenderer,
+        FrameProfiler& _profiler,
+        WorldProfiler& _worldProfiler,
         uint32_t queueFamilyIndex,
         VmaAllocator allocator
     );
 
     uint32_t beginFrame(
         std::queue<std::unique_ptr<MeshChunk::Data>> loadMeshes,
-        std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes
+        const EntityPosition& playerPosition,
+        std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes,
+        MeshChunk::BufferCache& meshBufferCache
     );
     void uploadMeshes(
         std::vector<VkBufferMemoryBarrier2>& bufferBarriers,
         std::queue<std::unique_ptr<MeshChunk::Data>> loadMeshes,
-        std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes
+        const EntityPosition& playerPosition,
+        std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes,
+        MeshChunk::BufferCache& meshBufferCache
     );
     void drawChunks(
         EntityPosition playerPosition,
         std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes
     );
     void endFrame(uint32_t imageIndex);
+    void readTimestamps();
+    void writeTimestamp(uint32_t query, VkPipelineStageFlags2 stage);
 
 public:
     FrameRenderer(
@@ -65,8 +94,11 @@ public:
         RenderResources& _renderResources,
         ChunkRenderer& _chunkRenderer,
         GuiRenderer& _guiRenderer,
+        FrameProfiler& _profiler,
+        WorldProfiler& _worldProfiler,
         uint32_t queueFamilyIndex,
-        VmaAllocator allocator
+        VmaAllocator allocator,
+        float _timestampPeriod
     );
     ~FrameRenderer();
 
@@ -80,8 +112,12 @@ public:
     void drawFrame(
         std::queue<std::unique_ptr<MeshChunk::Data>> loadMeshes,
         EntityPosition playerPosition,
-        std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes
+        float loadingProgress,
+        std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>>& chunkMeshes,
+        MeshChunk::BufferCache& meshBufferCache
     );
     void queueMeshForDeletion(std::unique_ptr<MeshChunk> mesh);
+
+    MeshUploadCounts getMeshUploadCounts() const;
 };
 
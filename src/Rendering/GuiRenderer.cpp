@@ -45,6 +45,53 @@ struct Vertex {
     }
 };
 
+
+
+// Adds a line of text at the given row from the top of the screen
+void addText(
+    std::vector<Vertex>& vertices,
+    std::vector<uint16_t>& indices,
+    const char* text,
+    int length,
+    int row,
+    float charWidth,
+    float charHeight
+) {
+    for (int i = 0; i < length; ++i) {
+        char c = text[i];
+        uint16_t tex = 0;
+        if (c == ' ') {
+            continue;
+        }
+        if ('0' <= c && c <= '9') {
+            tex = c - '0';
+        }
+        else if (c == '.') {
+            tex = 10;
+        }
+        else if (c == '-') {
+            tex = 11;
+        }
+
+        float xl = -1.0f + charWidth * static_cast<float>(i);
+        float xr = -1.0f + charWidth * static_cast<float>(i + 1);
+        float yl = -1.0f + charHeight * static_cast<float>(row);
+        float yu = -1.0f + charHeight * static_cast<float>(row + 1);
+        uint16_t baseIndex = static_cast<uint16_t>(vertices.size());
+        vertices.push_back(Vertex{.x = xl, .y = yl, .texture = tex});
+        vertices.push_back(Vertex{.x = xr, .y = yl, .texture = tex});
+        vertices.push_back(Vertex{.x = xr, .y = yu, .texture = tex});
+        vertices.push_back(Vertex{.x = xl, .y = yu, .texture = tex});
+
+        indices.push_back(baseIndex);
+        indices.push_back(baseIndex + 2);
+        indices.push_back(baseIndex + 1);
+        indices.push_back(baseIndex + 2);
+        indices.push_back(baseIndex);
+        indices.push_back(baseIndex + 3);
+    }
+}
+
 }
 
 
@@ -66,7 +113,7 @@ void GuiRenderer::createLayout(VkDescriptorSetLayout setLayout) {
 
 
 
-void GuiRenderer::createPipeline(const RenderTarget& renderTarget) {
+void GuiRenderer::createPipeline(const RenderTarget& renderTarget, VkPipelineCache pipelineCache) {
     VkFormat swapchainFormat = renderTarget.getColourFormat();
     VkPipelineRenderingCreateInfo renderingInfo{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
@@ -233,7 +280,7 @@ void GuiRenderer::createPipeline(const RenderTarget& renderTarget) {
         .basePipelineIndex{}
     };
     
-    VkResult result = vkCreateGraphicsPipelines(device, {}, 1, &createInfo, nullptr, &pipeline);
+    VkResult result = vkCreateGraphicsPipelines(device, pipelineCache, 1, &createInfo, nullptr, &pipeline);
     // Destroy the shader module regardless of whether the pipeline was successfully created
     vkDestroyShaderModule(device, shaderModule, nullptr);
     if (result != VK_SUCCESS) {
@@ -245,12 +292,10 @@ void GuiRenderer::createPipeline(const RenderTarget& renderTarget) {
 
 GuiRenderer::GuiRenderer(
     VkDevice _device,
-    const RenderTarget& renderTarget,
     VkDescriptorSetLayout setLayout
 ) : GuiRenderer() {
     device = _device;
     createLayout(setLayout);
-    createPipeline(renderTarget);
 }
 
 
@@ -266,8 +311,14 @@ void GuiRenderer::draw(
     VkCommandBuffer commandBuffer,
     VkExtent2D screenSize,
     LinearBufferSuballocator& transientBuffer,
-    EntityPosition playerPosition
+    EntityPosition playerPosition,
+    float loadingProgress,
+    std::span<const RollingStatistics::Percentiles> profileValues
 ) {
+    float charWidth = 24.0f / static_cast<float>(screenSize.width);
+    float charHeight = 32.0f / static_cast<float>(screenSize.height);
+    std::vector<Vertex> vertices;
+    std::vector<uint16_t> indices;
 
 	// Update coordinates
     char coordinateString[40]{};
@@ -279,44 +330,53 @@ void GuiRenderer::draw(
         playerPosition.pos.y,
         playerPosition.pos.z
     );
-    _length = std::min(_length, 40 - 1);
-
-    float charWidth = 24.0f / static_cast<float>(screenSize.width);
-    float charHeight = 32.0f / static_cast<float>(screenSize.height);
-    std::vector<Vertex> vertices;
-    std::vector<uint16_t> indices;
-    for (int i = 0; i < _length; ++i) {
-        char c = coordinateString[i];
-        uint16_t tex = 0;
-        if (c == ' ') {
-            continue;
-        }
-        if ('0' <= c && c <= '9') {
-            tex = c - '0';
-        }
-        else if (c == '.') {
-            tex = 10;
-        }
-        else if (c == '-') {
-            tex = 11;
-        }
-
-        float xl = -1.0f + charWidth * static_cast<float>(i);
-        float xr = -1.0f + charWidth * static_cast<float>(i + 1);
-        float yl = -1.0f;
-        float yu = -1.0f + charHeight;
-        uint16_t baseIndex = static_cast<uint16_t>(vertices.size());
-        vertices.push_back(Vertex{.x = xl, .y = yl, .texture = tex});
-        vertices.push_back(Vertex{.x = xr, .y = yl, .texture = tex});
-        vertices.push_back(Vertex{.x = xr, .y = yu, .texture = tex});
-        vertices.push_back(Vertex{.x = xl, .y = yu, .texture = tex});
+    addText(vertices, indices, coordinateString, std::min(_length, 40 - 1), 0, charWidth, charHeight);
+
+    // Loading indicator while the area around the player is generated after a teleport, a bar of dashes followed by
+    // the percentage done
+    if (loadingProgress < 1.0f) {
+        constexpr int BAR_LENGTH = 20;
+        char loadingString[40]{};
+        int barLength = static_cast<int>(loadingProgress * BAR_LENGTH);
+        for (int i = 0; i < BAR_LENGTH; ++i) loadingString[i] = i < barLength ? '-' : ' ';
+        int length = snprintf(
+            &loadingString[BAR_LENGTH],
+            40 - BAR_LENGTH,
+            " %5.1lf",
+            static_cast<double>(loadingProgress) * 100.0
+        );
+        addText(
+            vertices,
+            indices,
+            loadingString,
+            BAR_LENGTH + std::min(length, 40 - BAR_LENGTH - 1),
+            1,
+            charWidth,
+            charHeight
+        );
+    }
 
-		indices.push_back(baseIndex);
-		indices.push_back(baseIndex + 2);
-		indices.push_back(baseIndex + 1);
-		indices.push_back(baseIndex + 2);
-		indices.push_back(baseIndex);
-		indices.push_back(baseIndex + 3);
+    // Frame profile overlay, one row per stage (see FrameProfiler) showing p50 p95 p99 in milliseconds. The
+    // character set only contains digits, so the rows are in the same fixed order as the profile report.
+    for (size_t i = 0; i < profileValues.size(); ++i) {
+        char profileString[40]{};
+        int length = snprintf(
+            &profileString[0],
+            40,
+            "%8.3lf %8.3lf %8.3lf",
+            profileValues[i].p50,
+            profileValues[i].p95,
+            profileValues[i].p99
+        );
+        addText(
+            vertices,
+            indices,
+            profileString,
+            std::min(length, 40 - 1),
+            static_cast<int>(i) + 2,
+            charWidth,
+            charHeight
+        );
     }
 
     VkDeviceSize offsetVertices = transientBuffer.writeData(
@@ -1,6 +1,9 @@
 #pragma once
+#include <span>
+
 #include "LinearBufferSuballocator.h"
 #include "RenderTarget.h"
+#include "../Profiling/RollingStatistics.h"
 #include "../World/Entities/EntityPosition.h"
 
 
@@ -16,16 +19,17 @@ private:
     GuiRenderer() = default;
 
     void createLayout(VkDescriptorSetLayout setLayout);
-    void createPipeline(const RenderTarget& renderTarget);
     
 public:
     GuiRenderer(
         VkDevice _device,
-        const RenderTarget& renderTarget,
         VkDescriptorSetLayout setLayout
     );
     ~GuiRenderer();
 
+    // Called once after construction, alongside ChunkRenderer::createPipelines
+    void createPipeline(const RenderTarget& renderTarget, VkPipelineCache pipelineCache);
+
     GuiRenderer(GuiRenderer&&) = delete;
     GuiRenderer(const GuiRenderer&) = delete;
     GuiRenderer operator=(GuiRenderer&&) = delete;
@@ -35,7 +39,9 @@ public:
         VkCommandBuffer commandBuffer,
         VkExtent2D screenSize,
         LinearBufferSuballocator& transientBuffer,
-        EntityPosition playerPosition
+        EntityPosition playerPosition,
+        float loadingProgress,
+        std::span<const RollingStatistics::Percentiles> profileValues
     );
 
     VkPipelineLayout getLayout() const;
@@ -1,10 +1,14 @@
 #include "MeshChunk.h"
+#include <cstring>
 #include <numbers>
 #include <string>
 #include <vector>
 
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "../../Profiling/Trace.h"
+#include "../../World/BlockRegistry.h"
+#include "../../World/ChunkNeighbourhood.h"
 #include "../../World/World.h"
 
 
@@ -72,111 +76,57 @@ namespace {
 		uint32_t hZ = basicHash(static_cast<uint32_t>(pos.getZ()) + 0xac83);
 		return seedHash ^ basicHash(static_cast<uint32_t>(pos.getX())) ^ hY ^ hZ;
 	}
+
+
+
+	// Checks whether a host visible device local (ReBAR) heap exists with enough budget left for the allocation
+	bool directUploadHasBudget(VmaAllocator allocator, VkDeviceSize size)
+	{
+		constexpr VkMemoryPropertyFlags DIRECT_FLAGS =
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+		const VkPhysicalDeviceMemoryProperties* memoryProperties{};
+		vmaGetMemoryProperties(allocator, &memoryProperties);
+		std::array<VmaBudget, VK_MAX_MEMORY_HEAPS> budgets{};
+		vmaGetHeapBudgets(allocator, budgets.data());
+
+		for (uint32_t i = 0; i < memoryProperties->memoryTypeCount; ++i) {
+			const auto& memoryType = memoryProperties->memoryTypes[i];
+			if ((memoryType.propertyFlags & DIRECT_FLAGS) != DIRECT_FLAGS) continue;
+
+			// Keep some headroom so that mesh uploads never push the heap into eviction
+			const auto& budget = budgets[memoryType.heapIndex];
+			if (budget.usage + size <= budget.budget - budget.budget / 10) return true;
+		}
+		return false;
+	}
+
+
+
+	// Mesh buffers request mapped host access when a ReBAR heap has budget available. VMA will still fall back
+	// to unmappable device memory if it can't satisfy that, in which case the staging path is used instead.
+	Buffer createMeshBuffer(VmaAllocator allocator, VkDeviceSize size)
+	{
+		VmaAllocationCreateFlags allocationFlags{};
+		if (directUploadHasBudget(allocator, size)) {
+			allocationFlags =
+				VMA_ALLOCATION_CREATE_MAPPED_BIT |
+				VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+				VMA_ALLOCATION_CREATE_HOST_ACCESS_ALLOW_TRANSFER_INSTEAD_BIT;
+		}
+		return Buffer(
+			allocator,
+			size,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			allocationFlags,
+			VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+			{}
+		);
+	}
 }
 
 
 
-constexpr uint16_t BLOCK_TEXTURES[][6] = {
-	{0,  0,  0,  0,  0,  0 },
-	{0,  0,  0,  0,  0,  0 },
-	{2,  2,  2,  2,  2,  2 },
-	{3,  3,  3,  3,  3,  3 },
-	{4,  4,  4,  4,  4,  4 },
-	{5,  5,  5,  5,  5,  5 },
-	{6,  6,  6,  6,  6,  6 },
-	{7,  7,  7,  7,  7,  7 },
-	{8,  8,  8,  8,  8,  8 },
-	{9,  9,  9,  9,  9,  9 },
-	{10, 10, 10, 10, 10, 10},
-	{11, 11, 11, 11, 11, 11},
-	{12, 12, 12, 12, 12, 12},
-	{13, 13, 13, 13, 13, 13},
-	{14, 14, 14, 14, 14, 14},
-	{15, 15, 15, 15, 15, 15},
-	{16, 16, 16, 16, 16, 16},
-	{17, 17, 17, 17, 17, 17},
-	{18, 18, 18, 18, 18, 18}
-};
-constexpr bool IS_SOLID[] = {
-	false,
-	true,
-	true,
-	true,
-	false,
-	true,
-	false,
-	true,
-	true,
-	true,
-	false,
-	true,
-	false,
-	true,
-	false,
-	false,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true
-};
-constexpr int MESH_TYPE[] = {
-	0,
-	0,
-	0,
-	0,
-	0,
-	0,
-	2,
-	0,
-	0,
-	0,
-	1,
-	0,
-	0,
-	0,
-	1,
-	0,
-	0,
-	0,
-	0,
-	0,
-	0,
-	0
-};
-constexpr bool IS_ROTATEABLE[] = {
-	false,
-	true,
-	true,
-	false,
-	true,
-	true,
-	true,
-	true,
-	true,
-	false,
-	false,
-	true,
-	true,
-	false,
-	false,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true
-};
 constexpr uint8_t TEXTURE_COORDINATES[4][2] = {
 	{ 0, 0 },
 	{ 1, 0 },
@@ -189,12 +139,19 @@ constexpr uint8_t LIGHT[6] = { 255, 229, 240, 240, 220, 220 };
 
 
 
-MeshChunk::Data::Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neighbours)
+MeshChunk::Data::Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neighbours, bool positionIndependent)
  : position(chunkCentre->position)
 {
+	auto _geometry = std::make_shared<Geometry>();
+	geometry = _geometry;
+
 	// Skip loop if chunk is empty
 	if (chunkCentre->shouldSkipMeshing()) return;
 
+	const ChunkPos _rotationOrigin = positionIndependent ? ChunkPos(0, 0, 0) : position;
+
+	const ChunkNeighbourhood _neighbourhood(chunkCentre, neighbours);
+
 	// Cache transparency
 	auto _trans = chunkCentre->blockContainer.getSolid();
 	std::array<std::vector<bool>, 6> neighbourSolidMasks;
@@ -215,16 +172,18 @@ MeshChunk::Data::Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neig
 	for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
 	for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
 	for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
-		const ChunkLocalBlockPos _pos(x, y, z);
-		const auto _index = _pos.asIndex();
-		const Block block = chunkCentre->blockContainer.getBlock(_pos);
+		const auto _index = ChunkLocalBlockPos(x, y, z).asIndex();
+		const i32 _x = static_cast<i32>(x);
+		const i32 _y = static_cast<i32>(y);
+		const i32 _z = static_cast<i32>(z);
+		const Block block = _neighbourhood.getBlock(_x, _y, _z);
 		// Skip if air block
 		if (block.blockType == 0) continue;
 
-		switch (MESH_TYPE[block.blockType])
+		switch (BlockRegistry::getMeshType(block))
 		{
 		// Solid cube, the most basic and common mesh type
-		case 0: [[likely]]
+		case BlockMeshType::Cube: [[likely]]
 		{
 			// Offsets for every vertex to draw a cube
 			constexpr u8 FACE_TABLE[6][4][3] = {
@@ -235,8 +194,8 @@ MeshChunk::Data::Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neig
 				{{ 0, 1, 1 }, { 1, 1, 1 }, { 1, 0, 1 }, { 0, 0, 1 }}, // East
 				{{ 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 }, { 0, 0, 0 }}  // West
 			};
-			int rotationOffset = IS_ROTATEABLE[block.blockType] ?
-				static_cast<int>(getPositionHash(ChunkLocalBlockPos(x, y, z).asBlockPos(position), basicHash(1)) % 4) : 0;
+			int rotationOffset = BlockRegistry::isRotatable(block) ?
+				static_cast<int>(getPositionHash(ChunkLocalBlockPos(x, y, z).asBlockPos(_rotationOrigin), basicHash(1)) % 4) : 0;
 			bool faceIsVisible[6] = {
 				!(y != CHUNK_SIZE - 1 ? _trans[_index + CHUNK_SIZE] : neighbourSolidMasks[0][x * CHUNK_SIZE + z]),
 				!(y != 0 ? _trans[_index - CHUNK_SIZE] : neighbourSolidMasks[1][x * CHUNK_SIZE + z]),
@@ -259,7 +218,7 @@ MeshChunk::Data::Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neig
 							.z = static_cast<uint16_t>(z + FACE_TABLE[l][v][2]) * 16u,
 							.u = TEXTURE_COORDINATES[(v + rotationOffset) % 4][0],
 							.v = TEXTURE_COORDINATES[(v + rotationOffset) % 4][1],
-							.texture = BLOCK_TEXTURES[block.blockType][l],
+							.texture = BlockRegistry::getTextures(block)[l],
 							.light = LIGHT[l]
 						});
 					}
@@ -286,7 +245,7 @@ MeshChunk::Data::Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neig
 		}
 			break;
 		// Cross shaped plant
-		case 1: [[unlikely]]
+		case BlockMeshType::Cross: [[unlikely]]
 		{
 			uint16_t _dU = static_cast<uint16_t>(y + 1) * 16u;
 			uint16_t _dD = static_cast<uint16_t>(y)     * 16u;
@@ -294,7 +253,7 @@ MeshChunk::Data::Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neig
 			uint16_t _dS = static_cast<uint16_t>(x)     * 16u;
 			uint16_t _dE = static_cast<uint16_t>(z + 1) * 16u;
 			uint16_t _dW = static_cast<uint16_t>(z)     * 16u;
-			uint16_t _tex = BLOCK_TEXTURES[block.blockType][0];
+			uint16_t _tex = BlockRegistry::getTextures(block)[0];
 
 			uint32_t baseIndex = static_cast<uint32_t>(_verticesTested.size());
 
@@ -401,14 +360,13 @@ MeshChunk::Data::Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neig
 		}
 			break;
 		// Water
-		case 2:
+		case BlockMeshType::Liquid:
 		{
 			// Skip if block above is same type
-			if (((y != CHUNK_SIZE - 1) ? chunkCentre->getBlock(ChunkLocalBlockPos(x, y + 1, z)).blockType :
-				neighbours[0]->getBlock(ChunkLocalBlockPos(x, 0, z)).blockType) == block.blockType) continue;
+			if (_neighbourhood.getBlock(_x, _y + 1, _z) == block) continue;
 
-			int rotationOffset = IS_ROTATEABLE[block.blockType] ?
-				static_cast<int>(getPositionHash(ChunkLocalBlockPos(x, y, z).asBlockPos(position), basicHash(1)) % 4) : 0;
+			int rotationOffset = BlockRegistry::isRotatable(block) ?
+				static_cast<int>(getPositionHash(ChunkLocalBlockPos(x, y, z).asBlockPos(_rotationOrigin), basicHash(1)) % 4) : 0;
 
 			const uint16_t FACE_TABLE[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
 			
@@ -424,7 +382,7 @@ MeshChunk::Data::Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neig
 						.z = static_cast<uint16_t>(z + FACE_TABLE[v][1]) * 16u,
 						.u = TEXTURE_COORDINATES[(v + rotationOffset) % 4][0],
 						.v = TEXTURE_COORDINATES[(v + rotationOffset) % 4][1],
-						.texture = BLOCK_TEXTURES[block.blockType][l],
+						.texture = BlockRegistry::getTextures(block)[l],
 						.light = LIGHT[l]
 					});
 				}
@@ -444,6 +402,9 @@ MeshChunk::Data::Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neig
 			_indicesBlended.push_back(baseIndex + 4);
 		}
 			break;
+		// Unknown block types have no mesh
+		case BlockMeshType::None:
+			continue;
 		// Nah shit's gone wrong if this is triggered
 		default:
 			throw std::runtime_error("Meshing error: unkown mesh type");
@@ -452,16 +413,18 @@ MeshChunk::Data::Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neig
 	}
 	}
 
-	indexCountOpaque  = static_cast<uint32_t>(_indicesOpaque.size());
-	indexCountTested  = static_cast<uint32_t>(_indicesTested.size());
-	indexCountBlended = static_cast<uint32_t>(_indicesBlended.size());
+	_geometry->indexCountOpaque  = static_cast<uint32_t>(_indicesOpaque.size());
+	_geometry->indexCountTested  = static_cast<uint32_t>(_indicesTested.size());
+	_geometry->indexCountBlended = static_cast<uint32_t>(_indicesBlended.size());
 
 	// Merge the vertex and index vectors into one
+	auto& vertices = _geometry->vertices;
 	vertices = std::move(_verticesOpaque);
 	vertices.reserve(vertices.size() + _verticesTested.size() + _verticesBlended.size());
 	vertices.insert(vertices.end(), _verticesTested.begin(), _verticesTested.end());
 	vertices.insert(vertices.end(), _verticesBlended.begin(), _verticesBlended.end());
 
+	auto& indices = _geometry->indices;
 	indices = std::move(_indicesOpaque);
 	indices.reserve(indices.size() + _indicesTested.size() + _indicesBlended.size());
 	indices.insert(indices.end(), _indicesTested.begin(), _indicesTested.end());
@@ -470,8 +433,33 @@ MeshChunk::Data::Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neig
 
 
 
+MeshChunk::Data::Data(ChunkPos _position, std::shared_ptr<const Geometry> _geometry)
+ : position{_position}, geometry{std::move(_geometry)} {}
+
+
+
+// The mesher only looks at the blocks of the chunk itself, which blocks on the touching faces of the neighbours are
+// solid, and the block types on the bottom of the chunk above for water surfaces
+u64 MeshChunk::Data::getGeometryKey(const Chunk* chunkCentre, const std::array<Chunk*, 6> neighbours) {
+	u64 key = chunkCentre->getContentHash();
+	auto combine = [&](size_t hash) {
+		key ^= static_cast<u64>(hash) + 0x9e3779b97f4a7c15 + (key << 6) + (key >> 2);
+	};
+	for (unsigned i = 0; i < 6; ++i) {
+		combine(std::hash<std::vector<bool>>{}(neighbours[i]->getSolidFaceMask(static_cast<AxisDirection>(i ^ 1))));
+	}
+	for (i32 x = 0; x < CHUNK_SIZE; ++x) {
+	for (i32 z = 0; z < CHUNK_SIZE; ++z) {
+		combine(static_cast<size_t>(neighbours[0]->getBlock(ChunkLocalBlockPos(x, 0, z)).blockType));
+	}
+	}
+	return key;
+}
+
+
+
 bool MeshChunk::Data::isEmpty() const {
-	return indices.empty();
+	return geometry->indices.empty();
 }
 
 
@@ -482,45 +470,78 @@ ChunkPos MeshChunk::Data::getPosition() const {
 
 
 
+const std::shared_ptr<const MeshChunk::Geometry>& MeshChunk::Data::getGeometry() const {
+	return geometry;
+}
+
+
+
+std::chrono::steady_clock::time_point MeshChunk::Data::getTimeRequested() const {
+	return timeRequested;
+}
+
+
+
+void MeshChunk::Data::setTimeRequested(std::chrono::steady_clock::time_point _timeRequested) {
+	timeRequested = _timeRequested;
+}
+
+
+
 // Creates a chunk mesh using the passed data object, takes ownership of the meshData object
 MeshChunk::MeshChunk(
-	VkBufferMemoryBarrier2& barrier,
+	std::vector<VkBufferMemoryBarrier2>& bufferBarriers,
 	std::unique_ptr<MeshChunk::Data> _meshData,
 	VmaAllocator allocator,
 	VkCommandBuffer transferCommandBuffer,
-	LinearBufferSuballocator& stagingBuffer
+	LinearBufferSuballocator& stagingBuffer,
+	BufferCache& bufferCache
 ) :
 	meshData{std::move(_meshData)},
-	buffer(
-		allocator,
-		getVectorByteSize(meshData->vertices) + getVectorByteSize(meshData->indices),
-		VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-		{},
-		VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
-		{}
-	)
+	uploadPath{UploadPath::Staged}
 {
-	VkDeviceSize sizeVertices = getVectorByteSize(meshData->vertices);
-	VkDeviceSize sizeIndices = getVectorByteSize(meshData->indices);
-
+	TRACE_ZONE("MeshChunk::MeshChunk");
+	TRACE_FLOW_END("Chunk", TRACE_CHUNK_ID(meshData->position));
 
-	// TODO add a path for ReBAR which writes directly to the buffer
+	const Geometry& geometry = *meshData->geometry;
+	VkDeviceSize sizeVertices = getVectorByteSize(geometry.vertices);
+	VkDeviceSize sizeIndices = getVectorByteSize(geometry.indices);
 
+	offsetVertices = 0;
+	offsetIndices = sizeVertices;
 
-	
+	// The upload of a cached buffer has already been recorded along with its barrier, so it can be drawn from as is
+	auto& cachedBuffer = bufferCache[&geometry];
+	buffer = cachedBuffer.lock();
+	if (buffer) {
+		uploadPath = UploadPath::Shared;
+		return;
+	}
+	auto _buffer = std::make_shared<Buffer>(createMeshBuffer(allocator, sizeVertices + sizeIndices));
+	buffer = _buffer;
+	cachedBuffer = buffer;
+
+	// ReBAR path, the allocation landed in host visible device local memory so the data is written directly.
+	// Host writes are made visible to the device by the queue submission, so no copy or barrier is required.
+	if (_buffer->isMapped() && (_buffer->getMemoryProperties() & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+		char* mapping = static_cast<char*>(_buffer->getMappedPointer());
+		std::memcpy(mapping + offsetVertices, geometry.vertices.data(), sizeVertices);
+		std::memcpy(mapping + offsetIndices, geometry.indices.data(), sizeIndices);
+		_buffer->flush(0, VK_WHOLE_SIZE);
+		uploadPath = UploadPath::Direct;
+		return;
+	}
 
 	// Write data to staging buffer, and copy it into the buffer
 	VkDeviceSize stagingOfsetVertices = stagingBuffer.writeData(
-		meshData->vertices.data(),
+		geometry.vertices.data(),
 		sizeVertices
 	);
-	offsetVertices = 0;
 
 	static_cast<void>(stagingBuffer.writeData(
-		meshData->indices.data(),
+		geometry.indices.data(),
 		sizeIndices
 	));
-	offsetIndices = sizeVertices;
 
 	VkBufferCopy copyRegion{
 		.srcOffset = stagingOfsetVertices,
@@ -530,12 +551,12 @@ MeshChunk::MeshChunk(
 	vkCmdCopyBuffer(
 		transferCommandBuffer,
 		stagingBuffer.getHandle(),
-		buffer.getHandle(),
+		buffer->getHandle(),
 		1,
 		&copyRegion
 	);
 
-	barrier = VkBufferMemoryBarrier2{
+	bufferBarriers.push_back(VkBufferMemoryBarrier2{
         .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
         .pNext{},
         .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
@@ -544,10 +565,10 @@ MeshChunk::MeshChunk(
         .dstAccessMask = VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT,
         .srcQueueFamilyIndex{},
 		.dstQueueFamilyIndex{},
-		.buffer = buffer.getHandle(),
+		.buffer = buffer->getHandle(),
 		.offset{},
 		.size = VK_WHOLE_SIZE
-    };
+    });
 }
 
 
@@ -590,17 +611,17 @@ void MeshChunk::drawOpaque(
 	const glm::mat4& matrixProjectionView,
 	ChunkPos playerPosition
 ) const {
-	if (meshData->indexCountOpaque == 0) return;
+	if (meshData->geometry->indexCountOpaque == 0) return;
 	startDraw(
 		commandBuffer,
 		pipelineLayout,
 		matrixProjectionView,
 		playerPosition.offset(meshData->position),
-		buffer.getHandle(),
+		buffer->getHandle(),
 		offsetVertices,
 		offsetIndices
 	);
-	vkCmdDrawIndexed(commandBuffer, meshData->indexCountOpaque, 1, 0, 0, 0);
+	vkCmdDrawIndexed(commandBuffer, meshData->geometry->indexCountOpaque, 1, 0, 0, 0);
 }
 
 
@@ -611,22 +632,22 @@ void MeshChunk::drawTested(
 	const glm::mat4& matrixProjectionView,
 	ChunkPos playerPosition
 ) const {
-	if (meshData->indexCountTested == 0) return;
+	if (meshData->geometry->indexCountTested == 0) return;
 	startDraw(
 		commandBuffer,
 		pipelineLayout,
 		matrixProjectionView,
 		playerPosition.offset(meshData->position),
-		buffer.getHandle(),
+		buffer->getHandle(),
 		offsetVertices,
 		offsetIndices
 	);
 	vkCmdDrawIndexed(
 		commandBuffer,
-		meshData->indexCountTested,
+		meshData->geometry->indexCountTested,
 		1,
-		meshData->indexCountOpaque,
-		static_cast<int32_t>(meshData->indexCountOpaque / 3) * 2,
+		meshData->geometry->indexCountOpaque,
+		static_cast<int32_t>(meshData->geometry->indexCountOpaque / 3) * 2,
 		0
 	);
 }
@@ -639,22 +660,22 @@ void MeshChunk::drawBlended(
 	const glm::mat4& matrixProjectionView,
 	ChunkPos playerPosition
 ) const {
-	if (meshData->indexCountBlended == 0) return;
+	if (meshData->geometry->indexCountBlended == 0) return;
 	startDraw(
 		commandBuffer,
 		pipelineLayout,
 		matrixProjectionView,
 		playerPosition.offset(meshData->position),
-		buffer.getHandle(),
+		buffer->getHandle(),
 		offsetVertices,
 		offsetIndices
 	);
 	vkCmdDrawIndexed(
 		commandBuffer,
-		meshData->indexCountBlended,
+		meshData->geometry->indexCountBlended,
 		1,
-		meshData->indexCountOpaque + meshData->indexCountTested,
-		static_cast<int32_t>((meshData->indexCountOpaque + meshData->indexCountTested) / 3) * 2,
+		meshData->geometry->indexCountOpaque + meshData->geometry->indexCountTested,
+		static_cast<int32_t>((meshData->geometry->indexCountOpaque + meshData->geometry->indexCountTested) / 3) * 2,
 		0
 	);
 }
@@ -666,3 +687,15 @@ ChunkPos MeshChunk::getPosition() const {
 }
 
 
+
+MeshChunk::UploadPath MeshChunk::getUploadPath() const {
+	return uploadPath;
+}
+
+
+
+VkDeviceSize MeshChunk::getBufferSize() const {
+	return getVectorByteSize(meshData->geometry->vertices) + getVectorByteSize(meshData->geometry->indices);
+}
+
+
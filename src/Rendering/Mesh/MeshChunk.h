@@ -1,5 +1,7 @@
 #pragma once
+#include <chrono>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "../Buffer.h"
@@ -25,24 +27,41 @@ public:
 		static std::array<VkVertexInputAttributeDescription, 3> getAttributeDescriptions();
 	};
 
+	// Vertices and indices of a mesh, in chunk local coordinates so that chunks with the same mesh can share it
+	struct Geometry;
+
 	// In memory data class which can be used to construct a full MeshChunk which is backed by actual GPU buffers
 	class Data;
 
+	// Buffers of the meshes which have been uploaded, by the geometry in them, so that meshes sharing their geometry
+	// also share a buffer. Entries expire with the last mesh using the buffer.
+	using BufferCache = std::unordered_map<const Geometry*, std::weak_ptr<const Buffer>>;
+
+	// How the mesh data reached the GPU buffer
+	enum class UploadPath {
+		Direct,
+		Staged,
+		// Reused the buffer of another mesh with the same geometry
+		Shared
+	};
+
 private:
 	std::unique_ptr<MeshChunk::Data> meshData;
 
-	Buffer buffer;
+	std::shared_ptr<const Buffer> buffer;
+	UploadPath uploadPath;
 
 	VkDeviceSize offsetVertices;
 	VkDeviceSize offsetIndices;
 
 public:
 	MeshChunk(
-		VkBufferMemoryBarrier2& barrier,
+		std::vector<VkBufferMemoryBarrier2>& bufferBarriers,
 		std::unique_ptr<MeshChunk::Data> _meshData,
 		VmaAllocator allocator,
 		VkCommandBuffer transferCommandBuffer,
-		LinearBufferSuballocator& stagingBuffer
+		LinearBufferSuballocator& stagingBuffer,
+		BufferCache& bufferCache
 	);
 
 	MeshChunk(MeshChunk&&) = delete;
@@ -70,23 +89,38 @@ public:
 	) const;
 
 	ChunkPos getPosition() const;
+	UploadPath getUploadPath() const;
+	VkDeviceSize getBufferSize() const;
 };
 
 
 
-class MeshChunk::Data {
-private:
-	ChunkPos position;
-
+struct MeshChunk::Geometry {
 	std::vector<Vertex> vertices;
 	std::vector<uint32_t> indices;
 
 	uint32_t indexCountOpaque{};
 	uint32_t indexCountTested{};
 	uint32_t indexCountBlended{};
+};
+
+
+
+class MeshChunk::Data {
+private:
+	ChunkPos position;
+	std::shared_ptr<const Geometry> geometry;
+
+	std::chrono::steady_clock::time_point timeRequested;
 
 public:
-	Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neighbours);
+	// Position independent meshes take texture rotations from the chunk local position instead of the world position,
+	// so that chunks with the same blocks get the same geometry
+	Data(const Chunk* chunkCentre, const std::array<Chunk*, 6> neighbours, bool positionIndependent = false);
+	Data(ChunkPos _position, std::shared_ptr<const Geometry> _geometry);
+
+	// Everything that a position independent mesh is built from, chunks with the same key get the same geometry
+	static u64 getGeometryKey(const Chunk* chunkCentre, const std::array<Chunk*, 6> neighbours);
 
 	Data(Data&&) = delete;
 	Data(const Data&) = delete;
@@ -95,6 +129,9 @@ public:
 
 	bool isEmpty() const;
 	ChunkPos getPosition() const;
+	const std::shared_ptr<const Geometry>& getGeometry() const;
+	std::chrono::steady_clock::time_point getTimeRequested() const;
+	void setTimeRequested(std::chrono::steady_clock::time_point _timeRequested);
 
 	friend MeshChunk;
 };
@@ -0,0 +1,184 @@
+#include "PipelineCache.h"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "../GlobalLog.h"
+
+
+
+namespace {
+
+constexpr uint32_t CACHE_FILE_MAGIC = 0x43505652; // "RVPC"
+constexpr uint32_t CACHE_FILE_VERSION = 1;
+
+// Prepended to the driver provided data, this is checked before the data is handed back to the driver
+struct CacheFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint32_t dataSize;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+};
+
+
+
+std::string getCacheFilepath(VkPhysicalDevice physicalDevice) {
+    VkPhysicalDeviceIDProperties idProperties{};
+    idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &idProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    std::string filepath = "pipeline_cache_";
+    for (uint8_t byte : idProperties.deviceUUID) {
+        std::array<char, 3> hex{};
+        std::snprintf(hex.data(), hex.size(), "%02x", byte);
+        filepath += hex.data();
+    }
+    return filepath + ".bin";
+}
+
+
+
+// Validates the header that the driver writes at the start of its cache data
+bool driverHeaderMatches(const std::vector<char>& data, const VkPhysicalDeviceProperties& deviceProperties) {
+    VkPipelineCacheHeaderVersionOne header{};
+    if (data.size() < sizeof(header)) return false;
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    return (
+        header.headerSize >= sizeof(header) &&
+        header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        header.vendorID == deviceProperties.vendorID &&
+        header.deviceID == deviceProperties.deviceID &&
+        std::memcmp(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0
+    );
+}
+
+}
+
+
+
+// Returns the stored cache data, or nothing if there isn't any valid data for this device and driver
+std::vector<char> PipelineCache::loadCacheData() const {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) return {};
+
+    CacheFileHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return {};
+
+    if (
+        header.magic != CACHE_FILE_MAGIC ||
+        header.version != CACHE_FILE_VERSION ||
+        header.vendorID != deviceProperties.vendorID ||
+        header.deviceID != deviceProperties.deviceID ||
+        header.driverVersion != deviceProperties.driverVersion ||
+        std::memcmp(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0
+    ) {
+        LOG_INFO("Pipeline cache was created by a different device or driver, discarding it");
+        return {};
+    }
+
+    // The size is read from the file, so it has to fit in the rest of the file before anything is allocated for it
+    const std::streampos dataBegin = file.tellg();
+    file.seekg(0, std::ios::end);
+    const std::streamoff remainingSize = file.tellg() - dataBegin;
+    file.seekg(dataBegin);
+    if (!file || remainingSize < static_cast<std::streamoff>(header.dataSize)) {
+        LOG_INFO("Pipeline cache is corrupt, discarding it");
+        return {};
+    }
+
+    std::vector<char> data(header.dataSize);
+    if (!file.read(data.data(), static_cast<std::streamsize>(data.size())) || !driverHeaderMatches(data, deviceProperties)) {
+        LOG_INFO("Pipeline cache is corrupt, discarding it");
+        return {};
+    }
+    return data;
+}
+
+
+
+PipelineCache::PipelineCache(VkDevice _device, VkPhysicalDevice physicalDevice) : PipelineCache() {
+    device = _device;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+    filepath = getCacheFilepath(physicalDevice);
+
+    std::vector<char> initialData = loadCacheData();
+
+    VkPipelineCacheCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .pNext{},
+        .flags{},
+        .initialDataSize = initialData.size(),
+        .pInitialData = initialData.data()
+    };
+    if (vkCreatePipelineCache(device, &createInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline cache");
+    }
+
+    LOG_INFO("Loaded pipeline cache with " + std::to_string(initialData.size()) + " bytes");
+}
+
+
+
+PipelineCache::~PipelineCache() {
+    try {
+        save();
+    }
+    catch (const std::exception& error) {
+        LOG_WARNING(std::string("Failed to save pipeline cache: ") + error.what());
+    }
+
+    vkDestroyPipelineCache(device, pipelineCache, nullptr);
+}
+
+
+
+// Writes the cache to a temporary file first, so that an interrupted write never leaves a truncated cache behind
+void PipelineCache::save() const {
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, nullptr) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to get pipeline cache size");
+    }
+    std::vector<char> data(dataSize);
+    if (vkGetPipelineCacheData(device, pipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to get pipeline cache data");
+    }
+
+    CacheFileHeader header{
+        .magic = CACHE_FILE_MAGIC,
+        .version = CACHE_FILE_VERSION,
+        .vendorID = deviceProperties.vendorID,
+        .deviceID = deviceProperties.deviceID,
+        .driverVersion = deviceProperties.driverVersion,
+        .dataSize = static_cast<uint32_t>(dataSize),
+        .pipelineCacheUUID{}
+    };
+    std::memcpy(header.pipelineCacheUUID, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    const std::string temporaryFilepath = filepath + ".tmp";
+    {
+        std::ofstream file(temporaryFilepath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(data.data(), static_cast<std::streamsize>(dataSize));
+        if (!file) {
+            throw std::runtime_error("Failed to write pipeline cache file");
+        }
+    }
+    if (std::rename(temporaryFilepath.c_str(), filepath.c_str()) != 0) {
+        throw std::runtime_error("Failed to replace pipeline cache file");
+    }
+}
+
+
+
+VkPipelineCache PipelineCache::get() const { return pipelineCache; }
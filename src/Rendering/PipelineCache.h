@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Vulkan_Headers.h"
+
+
+
+// On disk backed VkPipelineCache. The file is keyed by the device UUID, and the stored data is only used if it
+// was produced by the same device and driver version.
+class PipelineCache {
+private:
+    VkDevice device{};
+    VkPipelineCache pipelineCache{};
+    VkPhysicalDeviceProperties deviceProperties{};
+    std::string filepath;
+
+private:
+    PipelineCache() = default;
+
+    std::vector<char> loadCacheData() const;
+
+public:
+    PipelineCache(VkDevice _device, VkPhysicalDevice physicalDevice);
+    ~PipelineCache();
+
+    PipelineCache(PipelineCache&&) = delete;
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache operator=(PipelineCache&&) = delete;
+    PipelineCache operator=(const PipelineCache&) = delete;
+
+    void save() const;
+
+    VkPipelineCache get() const;
+};
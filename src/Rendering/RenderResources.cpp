@@ -1,12 +1,15 @@
 #include "RenderResources.h"
 
 #include <array>
+#include <chrono>
+#include <cstring>
 #include <stdexcept>
+#include <string>
 
-#include <lodepng/lodepng.h>
-
+#include "BakedTexture.h"
+#include "Buffer.h"
 #include "Fence.h"
-#include "LinearBufferSuballocator.h"
+#include "../GlobalLog.h"
 #include "Vulkan_Utils.h"
 #include "SingleCommandBuffer.h"
 
@@ -14,49 +17,58 @@
 
 namespace {
 
-struct TextureLoadInfo{
-    const char* filepath;
-    uint32_t cellWidth;
-    uint32_t cellHeight;
-    uint32_t mipLevelCount;
-};
-constexpr std::array TEXTURE_INFOS{
-    TextureLoadInfo{"res/textures/texture_atlas.png", 16u, 16u, 4u},
-    TextureLoadInfo{"res/textures/character_set.png", 6u,  8u,  1u}
-};
+// Returns the baked texture data, either straight from the mapped file or by rebaking it from the source image
+const unsigned char* getTextureData(
+    const TextureSource& source,
+    const BakedTextureFile& bakedFile,
+    BakedTexture& rebaked,
+    BakedTextureHeader& header
+) {
+    if (bakedFile.isCurrent(source)) {
+        header = bakedFile.getHeader();
+        return bakedFile.getData();
+    }
+
+    LOG_INFO(std::string("Baked texture ") + source.bakedPath + " is missing or stale, decoding the source image");
+    rebaked = bakeTexture(source);
+    try {
+        writeBakedTexture(source.bakedPath, rebaked);
+    }
+    catch (const std::exception& e) {
+        LOG_WARNING(std::string("Failed to write baked texture: ") + e.what());
+    }
+    header = rebaked.header;
+    return rebaked.data.data();
+}
 
 }
 
 
 
-// The fence that this returns must be waited on
 void RenderResources::createTextures(VkQueue queue, uint32_t queueIndex) {
+    auto timeStart = std::chrono::steady_clock::now();
     SingleCommandBuffer commandBuffer(device, queueIndex);
-    // TODO don't use a buffer suballocator for single allocation buffers
-    std::vector<LinearBufferSuballocator> uploadBuffers;
+    std::vector<Buffer> uploadBuffers;
 
     Fence fenceUploadsComplete(device, {});
  
-    for (auto [path, cellWidth, cellHeight, mipLevelCount] : TEXTURE_INFOS) {
-        std::vector<unsigned char> imageData;
-        unsigned width;
-        unsigned height;
-        if (lodepng::decode(imageData, width, height, path)) {
-            throw std::runtime_error("Failed to read texture data");
-        }
+    for (const auto& source : TEXTURE_SOURCES) {
+        BakedTextureFile bakedFile(source.bakedPath);
+        BakedTexture rebaked;
+        BakedTextureHeader header;
+        const unsigned char* textureData = getTextureData(source, bakedFile, rebaked, header);
 
-        // Error if the texture isn't a grid of TEXTURE_SIZE sized squares
-        if (width % cellWidth != 0 || height % cellHeight != 0) {
-            throw std::runtime_error("Invalid texture size");
-        }
-        uint32_t textureGridWidth = width / cellWidth;
-        uint32_t textureGridHeight = height / cellHeight;
-        uint32_t textureCount = textureGridWidth * textureGridHeight;
-    
-        VkDeviceSize imageSize = width * height * 4;
-        uploadBuffers.emplace_back(allocator, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, false);
+        uploadBuffers.emplace_back(
+            allocator,
+            header.dataSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT,
+            VMA_MEMORY_USAGE_AUTO,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
         auto& uploadBuffer = uploadBuffers.back();
-        static_cast<void>(uploadBuffer.writeData(imageData.data(), imageSize));
+        std::memcpy(uploadBuffer.getMappedPointer(), textureData, header.dataSize);
+        uploadBuffer.flush(0, header.dataSize);
     
         textures.push_back({});
         auto& texture = textures.back();
@@ -68,15 +80,15 @@ void RenderResources::createTextures(VkQueue queue, uint32_t queueIndex) {
             .imageType = VK_IMAGE_TYPE_2D,
             .format = VK_FORMAT_R8G8B8A8_SRGB,
             .extent{
-                .width = cellWidth,
-                .height = cellHeight,
+                .width = header.cellWidth,
+                .height = header.cellHeight,
                 .depth = 1
             },
-            .mipLevels = mipLevelCount,
-            .arrayLayers = textureCount,
+            .mipLevels = header.mipLevelCount,
+            .arrayLayers = header.layerCount,
             .samples = VK_SAMPLE_COUNT_1_BIT,
             .tiling = VK_IMAGE_TILING_OPTIMAL,
-            .usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             .sharingMode{},
             .queueFamilyIndexCount{},
             .pQueueFamilyIndices{},
@@ -129,31 +141,27 @@ void RenderResources::createTextures(VkQueue queue, uint32_t queueIndex) {
             }
         );
 
+        // The layers of each mip level are tightly packed, so every level is a single copy
         std::vector<VkBufferImageCopy> copyRegions;
-        copyRegions.reserve(textureCount);
-        for (uint32_t row = 0; row < textureGridHeight; ++row) {
-            for (uint32_t col = 0; col < textureGridWidth; ++col) {
-                uint32_t bufferOffset = (row * textureGridWidth * cellWidth * cellHeight + col * cellWidth) * 4;
-                uint32_t arrayIndex = row * textureGridWidth + col;
-
-                copyRegions.push_back(VkBufferImageCopy{
-                    .bufferOffset = bufferOffset,
-                    .bufferRowLength = width,
-                    .bufferImageHeight = height,
-                    .imageSubresource{
-                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                        .mipLevel = 0,
-                        .baseArrayLayer = arrayIndex,
-                        .layerCount = 1
-                    },
-                    .imageOffset{},
-                    .imageExtent{
-                        .width = cellWidth,
-                        .height = cellHeight,
-                        .depth = 1
-                    }
-                });
-            }
+        copyRegions.reserve(header.mipLevelCount);
+        for (uint32_t level = 0; level < header.mipLevelCount; ++level) {
+            copyRegions.push_back(VkBufferImageCopy{
+                .bufferOffset = getMipLevelOffset(header, level),
+                .bufferRowLength{},
+                .bufferImageHeight{},
+                .imageSubresource{
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .mipLevel = level,
+                    .baseArrayLayer = 0,
+                    .layerCount = header.layerCount
+                },
+                .imageOffset{},
+                .imageExtent{
+                    .width = getMipWidth(header, level),
+                    .height = getMipHeight(header, level),
+                    .depth = 1
+                }
+            });
         }
 
         vkCmdCopyBufferToImage(
@@ -165,159 +173,30 @@ void RenderResources::createTextures(VkQueue queue, uint32_t queueIndex) {
             copyRegions.data()
         );
 
-        if (mipLevelCount > 1) {
-            uint32_t mipWidth = cellWidth;
-            uint32_t mipHeight = cellHeight;
-            for (uint32_t level = 1; level < mipLevelCount; ++level) {
-                if (mipWidth > 1) mipWidth /= 2;
-                if (mipHeight > 1) mipHeight /= 2;
-
-                // Transition the previous mip level from TRANSFER_DST_OPTIMAL to TRANSFER_SRC_OPTIMAL
-                addPipelineImageBarrier(
-                    commandBuffer.getBuffer(),
-                    VkImageMemoryBarrier2{
-                        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                        .pNext{},
-                        .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
-                        .dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                        .dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT,
-                        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                        .srcQueueFamilyIndex{},
-                        .dstQueueFamilyIndex{},
-                        .image = texture.image,
-                        .subresourceRange{
-                            .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                            .baseMipLevel = level - 1,
-                            .levelCount = 1,
-                            .baseArrayLayer = 0,
-                            .layerCount = VK_REMAINING_ARRAY_LAYERS
-                        }
-                    }
-                );
-
-                VkImageBlit2 blitRegion{
-                    .sType = VK_STRUCTURE_TYPE_IMAGE_BLIT_2,
-                    .pNext{},
-                    .srcSubresource{
-                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                        .mipLevel = level - 1,
-                        .baseArrayLayer = 0,
-                        .layerCount = textureCount
-                    },
-                    .srcOffsets{
-                        VkOffset3D{},
-                        VkOffset3D{static_cast<int32_t>(mipWidth), static_cast<int32_t>(mipHeight), 1},
-                    },
-                    .dstSubresource{
-                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                        .mipLevel = level,
-                        .baseArrayLayer = 0,
-                        .layerCount = textureCount
-                    },
-                    .dstOffsets{
-                        VkOffset3D{},
-                        VkOffset3D{static_cast<int32_t>(mipWidth), static_cast<int32_t>(mipHeight), 1},
-                    }
-                };
-                VkBlitImageInfo2 blitInfo{
-                    .sType = VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2,
-                    .pNext{},
-                    .srcImage = texture.image,
-                    .srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                    .dstImage = texture.image,
-                    .dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                    .regionCount = 1,
-                    .pRegions = &blitRegion,
-                    .filter = VK_FILTER_LINEAR
-                };
-                vkCmdBlitImage2(commandBuffer.getBuffer(), &blitInfo);
-            }
-
-            // Transition the whole image into SHADER_READ_ONLY_OPTIMAL
-            // Currently the last mip level is in TRANSFER_DST_OPTIMAL and all others are TRANSFER_SRC_OPTIMAL
-            std::array imageBarriers{
-                VkImageMemoryBarrier2{
-                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                    .pNext{},
-                    .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                    .srcAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT,
-                    .dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
-                    .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT,
-                    .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                    .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                    .srcQueueFamilyIndex{},
-                    .dstQueueFamilyIndex{},
-                    .image = texture.image,
-                    .subresourceRange{
-                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                        .baseMipLevel = 0,
-                        .levelCount = mipLevelCount - 1,
-                        .baseArrayLayer = 0,
-                        .layerCount = VK_REMAINING_ARRAY_LAYERS
-                    }
-                },
-                VkImageMemoryBarrier2{
-                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                    .pNext{},
-                    .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                    .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
-                    .dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
-                    .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT,
-                    .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                    .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                    .srcQueueFamilyIndex{},
-                    .dstQueueFamilyIndex{},
-                    .image = texture.image,
-                    .subresourceRange{
-                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                        .baseMipLevel = mipLevelCount - 1,
-                        .levelCount = 1,
-                        .baseArrayLayer = 0,
-                        .layerCount = VK_REMAINING_ARRAY_LAYERS
-                    }
-                }
-            };
-            VkDependencyInfo dependencyInfo{
-                .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        // Transition the image into SHADER_READ_ONLY_OPTIMAL
+        addPipelineImageBarrier(
+            commandBuffer.getBuffer(),
+            VkImageMemoryBarrier2{
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
                 .pNext{},
-                .dependencyFlags{},
-                .memoryBarrierCount{},
-                .pMemoryBarriers{},
-                .bufferMemoryBarrierCount{},
-                .pBufferMemoryBarriers{},
-                .imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size()),
-                .pImageMemoryBarriers = imageBarriers.data()
-            };
-            vkCmdPipelineBarrier2(commandBuffer.getBuffer(), &dependencyInfo);
-        }
-        else {
-            // Transition the image into SHADER_READ_ONLY_OPTIMAL
-            addPipelineImageBarrier(
-                commandBuffer.getBuffer(),
-                VkImageMemoryBarrier2{
-                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-                    .pNext{},
-                    .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
-                    .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
-                    .dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
-                    .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT,
-                    .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                    .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                    .srcQueueFamilyIndex{},
-                    .dstQueueFamilyIndex{},
-                    .image = texture.image,
-                    .subresourceRange{
-                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                        .baseMipLevel = 0,
-                        .levelCount = 1,
-                        .baseArrayLayer = 0,
-                        .layerCount = VK_REMAINING_ARRAY_LAYERS
-                    }
+                .srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                .srcQueueFamilyIndex{},
+                .dstQueueFamilyIndex{},
+                .image = texture.image,
+                .subresourceRange{
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 0,
+                    .levelCount = VK_REMAINING_MIP_LEVELS,
+                    .baseArrayLayer = 0,
+                    .layerCount = VK_REMAINING_ARRAY_LAYERS
                 }
-            );
-        }
+            }
+        );
 
         VkImageViewCreateInfo viewCreateInfo{
             .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
@@ -389,6 +268,9 @@ void RenderResources::createTextures(VkQueue queue, uint32_t queueIndex) {
     if (vkWaitForFences(device, 1, &fence, {}, UINT64_MAX)) {
         throw std::runtime_error("Failed to wait for fence");
     }
+
+    auto loadTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - timeStart);
+    LOG_INFO("Loaded textures in " + std::to_string(loadTime.count()) + "us");
 }
 
 
@@ -1,9 +1,13 @@
 #include "Renderer.h"
 #include <algorithm>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
 
 #include "../GlobalLog.h"
-
-using namespace std::chrono_literals;
+#include "../Profiling/Trace.h"
+#include "../Threading/SimulationClock.h"
 
 
 
@@ -12,13 +16,44 @@ constexpr int RENDER_AHEAD_COUNT = 3;
 
 
 void Renderer::processFrame() {
+	{
+		FrameProfiler::ScopedTimer timer(frameProfiler, FrameProfiler::CpuStage::Frame);
+		drawFrame();
+	}
+	frameProfiler.endFrame();
+}
+
+
+
+void Renderer::drawFrame() {
+	PlayerSnapshot snapshot = sharedGameState->playerSnapshot.load();
+	auto timeNow = std::chrono::steady_clock::now();
+
+	// The renderer never drives the simulation, it only notices when the snapshot it is drawing is overdue
+	auto snapshotAge = std::chrono::duration_cast<std::chrono::microseconds>(timeNow - snapshot.publishedTimestamp);
+	auto snapshotSlip = std::max(snapshotAge - SimulationClock::TICK_INTERVAL, std::chrono::microseconds{0});
+	if (snapshotSlip.count()) staleSnapshotFrames++;
+	maxSnapshotSlip = std::max(maxSnapshotSlip, snapshotSlip);
+	TRACE_COUNTER("Snapshot slip (us)", snapshotSlip.count());
+
 	std::queue<std::unique_ptr<MeshChunk::Data>> loadMeshQueue;
 	sharedGameState->chunkMeshQueue->getQueue(loadMeshQueue);
-	EntityPosition playerPos = sharedGameState->playerPosition.load();
+	// Draw one tick behind the simulation, so that the camera moves smoothly between the last two ticks. Progress is
+	// measured from when the snapshot was published rather than when its tick started, otherwise the time spent
+	// running the tick would show up as a jump every time a new snapshot arrives
+	double tickProgress = std::clamp(
+		std::chrono::duration<double>(timeNow - snapshot.publishedTimestamp).count() /
+		std::chrono::duration<double>(snapshot.nextTickTimestamp - snapshot.tickTimestamp).count(),
+		0.0,
+		1.0
+	);
+	EntityPosition playerPos = EntityPosition::interpolate(snapshot.previous, snapshot.current, tickProgress);
 	frameRenderers[currentFrameRendererIndex].drawFrame(
 		std::move(loadMeshQueue),
 		playerPos,
-		meshesChunk
+		sharedGameState->loadingProgress.load(std::memory_order_relaxed),
+		meshesChunk,
+		meshBufferCache
 	);
 	unloadMeshes(ChunkPos(playerPos));
 	
@@ -29,19 +64,20 @@ void Renderer::processFrame() {
 
 // Need to defer deletion
 void Renderer::unloadMeshes(const ChunkPos& playerChunk) {
-	std::queue<ChunkPos> removeQueue;
+	// Chunks that didn't fit in the deletion queue on a previous frame are sent first
+	std::queue<ChunkPos>& removeQueue = pendingMeshDeletions;
 	
+	// Meshes are kept for as long as the world keeps their chunks, including the unload margin
 	ChunkPos2D _playerChunk2D(playerChunk);
-	const long long _loadDistanceHorizontalSquared = (
-		static_cast<long long>(settings.getLoadDistanceHorizontal()) *
-		settings.getLoadDistanceHorizontal()
-	);
+	const long long _unloadDistanceHorizontal = settings.getLoadDistanceHorizontal() + settings.getUnloadMargin();
+	const long long _unloadDistanceHorizontalSquared = _unloadDistanceHorizontal * _unloadDistanceHorizontal;
+	const long long _unloadDistanceVertical = settings.getLoadDistanceVertical() + settings.getUnloadMargin();
 
 	auto it = meshesChunk.begin();
 	while (it != meshesChunk.end()) {
 		if (
-			_playerChunk2D.distanceEuclideanSquared(it->first) > _loadDistanceHorizontalSquared ||
-			std::abs(playerChunk.getY() - it->first.getY()) > settings.getLoadDistanceVertical()
+			_playerChunk2D.distanceEuclideanSquared(it->first) > _unloadDistanceHorizontalSquared ||
+			std::abs(playerChunk.getY() - it->first.getY()) > _unloadDistanceVertical
 		) {
 			removeQueue.push(it->first);
 			frameRenderers[currentFrameRendererIndex].queueMeshForDeletion(std::move(it->second));
@@ -50,8 +86,11 @@ void Renderer::unloadMeshes(const ChunkPos& playerChunk) {
 		else it++;
 	}
 	
-	// Add the removed chunks if any were removed
-	if (removeQueue.size()) sharedGameState->chunkMeshQueueDeletion->mergeQueue(removeQueue);
+	// Add the removed chunks if any were removed, whatever doesn't fit is retried next frame
+	if (removeQueue.size()) {
+		sharedGameState->chunkMeshQueueDeletion->mergeQueue(removeQueue);
+		std::erase_if(meshBufferCache, [](const auto& entry) { return entry.second.expired(); });
+	}
 }
 
 
@@ -62,12 +101,17 @@ Renderer::Renderer(
 	std::atomic_bool& _applicationShouldTerminate,
 	std::shared_ptr<SharedGameRendererState> _sharedGameState
 ) :
+	timeConstructionBegin{std::chrono::steady_clock::now()},
 	settings{_settings},
 	window{_window},
 	vulkanContext(
 		window,
 		settings.getValidationLayersEnabled()
 	),
+	pipelineCache(
+		vulkanContext.getDevice(),
+		vulkanContext.getPhysicalDevice()
+	),
 	renderTarget(
 		window,
 		vulkanContext.getPhysicalDevice(),
@@ -83,17 +127,33 @@ Renderer::Renderer(
 	),
 	chunkRenderer(
 		vulkanContext.getDevice(),
-		renderTarget,
 		renderResources.getDescriptorLayout()
 	),
 	guiRenderer(
 		vulkanContext.getDevice(),
-		renderTarget,
 		renderResources.getDescriptorLayout()
 	),
+	frameProfiler(
+		settings.getProfilerReportPath(),
+		settings.getProfilerReportInterval(),
+		settings.getProfilerOverlayEnabled()
+	),
 	applicationShouldTerminate{_applicationShouldTerminate},
 	sharedGameState{std::move(_sharedGameState)}
 {
+	// The GUI pipeline is created on its own thread while the chunk pipelines are created on theirs. If one of them
+	// fails the renderers still destroy the pipelines that were created.
+	auto timePipelinesBegin = std::chrono::steady_clock::now();
+	auto futureGuiPipeline = std::async(std::launch::async, [this] {
+		guiRenderer.createPipeline(renderTarget, pipelineCache.get());
+	});
+	chunkRenderer.createPipelines(renderTarget, pipelineCache.get());
+	futureGuiPipeline.get();
+	auto timePipelines = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - timePipelinesBegin
+	);
+	LOG_INFO("Created pipelines in " + std::to_string(timePipelines.count()) + "ms");
+
 	frameRenderers.reserve(RENDER_AHEAD_COUNT);
 	for (int i = 0; i < RENDER_AHEAD_COUNT; ++i) {
 		frameRenderers.emplace_back(
@@ -103,30 +163,74 @@ Renderer::Renderer(
 			renderResources,
 			chunkRenderer,
 			guiRenderer,
+			frameProfiler,
+			sharedGameState->worldProfiler,
 			vulkanContext.getQueueGraphicsFamily(),
-			vulkanContext.getAllocator()
+			vulkanContext.getAllocator(),
+			vulkanContext.getTimestampPeriod()
 		);
 	}
 
-	GlobalLog.Write("Created renderer");
+	// Write the cache out immediately so that a crash later on doesn't lose the compiled pipelines
+	try {
+		pipelineCache.save();
+	}
+	catch (const std::exception& e) {
+		LOG_WARNING(std::string("Failed to save pipeline cache: ") + e.what());
+	}
+
+	LOG_INFO("Created renderer");
 }
 
 
 
 Renderer::~Renderer() {
 	vulkanContext.waitDeviceIdle();
+
+	FrameRenderer::MeshUploadCounts uploadCounts;
+	for (const auto& frameRenderer : frameRenderers) {
+		uploadCounts.direct += frameRenderer.getMeshUploadCounts().direct;
+		uploadCounts.staged += frameRenderer.getMeshUploadCounts().staged;
+		uploadCounts.shared += frameRenderer.getMeshUploadCounts().shared;
+		uploadCounts.sharedBytes += frameRenderer.getMeshUploadCounts().sharedBytes;
+	}
+	LOG_INFO(
+		"Chunk mesh uploads: " + std::to_string(uploadCounts.direct) + " direct, " +
+		std::to_string(uploadCounts.staged) + " staged, " + std::to_string(uploadCounts.shared) + " shared saving " +
+		std::to_string(uploadCounts.sharedBytes / 1024) + "KiB"
+	);
+
+	auto logQueueCounters = [](const char* name, const auto& queue) {
+		auto counters = queue.getCounters();
+		LOG_INFO(
+			std::string(name) + ": capacity " + std::to_string(queue.getCapacity()) +
+			", high water " + std::to_string(counters.highWaterMark) +
+			", contended pushes " + std::to_string(counters.contendedPushes) +
+			", rejected pushes " + std::to_string(counters.rejectedPushes)
+		);
+	};
+	logQueueCounters("Chunk mesh queue", *sharedGameState->chunkMeshQueue);
+	logQueueCounters("Chunk mesh deletion queue", *sharedGameState->chunkMeshQueueDeletion);
+
+	LOG_INFO(
+		"Frames drawn with an overdue game snapshot: " + std::to_string(staleSnapshotFrames) +
+		", max slip " + std::to_string(maxSnapshotSlip.count()) + "us"
+	);
 }
 
 
 
 void Renderer::run() {
+	TRACE_THREAD_NAME("Render");
 	while (applicationShouldTerminate.load() == false) {
-		if (std::chrono::steady_clock::now() > sharedGameState->nextTickTimestamp) {
-			sharedGameState->nextTickTimestamp += 20ms;
-			sharedGameState->currentTick++;
-			sharedGameState->currentTick.notify_all();
-		}
-		
 		processFrame();
+
+		if (!firstFramePresented) {
+			firstFramePresented = true;
+			auto timeToFirstFrame = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now() - timeConstructionBegin
+			);
+			LOG_INFO("Time to first frame: " + std::to_string(timeToFirstFrame.count()) + "ms");
+		}
 	}
 }
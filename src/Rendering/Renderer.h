@@ -1,10 +1,13 @@
 #pragma once
+#include <chrono>
 #include <memory>
+#include <queue>
 #include <unordered_map>
 
 #include "ChunkRenderer.h"
 #include "FrameRenderer.h"
 #include "GuiRenderer.h"
+#include "PipelineCache.h"
 #include "RenderResources.h"
 #include "RenderTarget.h"
 #include "VulkanContext.h"
@@ -21,22 +24,35 @@
 class Renderer
 {
 private:
+	// Declared first so that it is initialised before any of the Vulkan objects are created
+	std::chrono::steady_clock::time_point timeConstructionBegin;
+	bool firstFramePresented = false;
+
 	const Settings& settings;
 
 	// Vulkan Stuff
 	GLFWwindow* window;
 	VulkanContext vulkanContext;
+	PipelineCache pipelineCache;
     RenderTarget renderTarget;
     RenderResources renderResources;
     ChunkRenderer chunkRenderer;
 	GuiRenderer guiRenderer;
 
+	FrameProfiler frameProfiler;
     std::vector<FrameRenderer> frameRenderers;
 	
 	size_t currentFrameRendererIndex = 0;
 
+	// Frames drawn from a game snapshot more than a tick older than it should be, and the worst lateness seen
+	uint64_t staleSnapshotFrames = 0;
+	std::chrono::microseconds maxSnapshotSlip{};
+
 	// Drawables
 	std::unordered_map<ChunkPos, std::unique_ptr<MeshChunk>> meshesChunk;
+	MeshChunk::BufferCache meshBufferCache;
+	// Unloaded chunks which the game thread still has to be told about
+	std::queue<ChunkPos> pendingMeshDeletions;
 
 	// Threading Stuff
 	std::atomic_bool& applicationShouldTerminate;
@@ -48,6 +64,7 @@ private:
 
 private:
 	void processFrame();
+	void drawFrame();
 	void unloadMeshes(const ChunkPos& playerChunk);
 	
 public:
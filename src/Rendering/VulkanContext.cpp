@@ -171,8 +171,23 @@ uint32_t getQueueIndexGraphics(VkPhysicalDevice physicalDevice, VkSurfaceKHR sur
 
 
 
+float queryTimestampPeriod(VkPhysicalDevice physicalDevice, uint32_t queueIndex) {
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+    if (!queueFamilies[queueIndex].timestampValidBits) return 0.0f;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    return properties.limits.timestampPeriod;
+}
+
+
+
 void VulkanContext::createDevice() {
     queueGraphicsIndex = getQueueIndexGraphics(physicalDevice, surface);
+    timestampPeriod = queryTimestampPeriod(physicalDevice, queueGraphicsIndex);
 
     constexpr float priority = 1.0;
     VkDeviceQueueCreateInfo queueGraphicsCreateInfo{
@@ -290,3 +305,4 @@ VkDevice VulkanContext::getDevice() const { return device; }
 uint32_t VulkanContext::getQueueGraphicsFamily() const { return queueGraphicsIndex; }
 VkQueue VulkanContext::getQueueGraphics() const { return queueGraphics; }
 VmaAllocator VulkanContext::getAllocator() const { return allocator; }
+float VulkanContext::getTimestampPeriod() const { return timestampPeriod; }
@@ -13,6 +13,7 @@ private:
     uint32_t queueGraphicsIndex{};
     VkQueue queueGraphics{};
     VmaAllocator allocator{};
+    float timestampPeriod{};
 
 private:
     VulkanContext() = default;
@@ -41,4 +42,6 @@ public:
     uint32_t getQueueGraphicsFamily() const;
     VkQueue  getQueueGraphics() const;
     VmaAllocator getAllocator() const;
+    // Nanoseconds per timestamp tick, zero if the graphics queue doesn't support timestamp queries
+    float getTimestampPeriod() const;
 };
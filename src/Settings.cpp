@@ -12,11 +12,26 @@ Settings::Settings() try {
 
     loadDistanceHorizontal = static_cast<uint32_t>(json["loadDistanceHorizontal"].get_uint64());
     loadDistanceVertical = static_cast<uint32_t>(json["loadDistanceVertical"].get_uint64());
+    unloadMargin = static_cast<uint32_t>(json["unloadMargin"].get_uint64());
+    chunkPipelineBudgetMin = json["chunkPipelineBudgetMin"].get_double();
+    chunkPipelineBudgetMax = json["chunkPipelineBudgetMax"].get_double();
+    chunkPipelineTickReserve = json["chunkPipelineTickReserve"].get_double();
+    worldPath = std::string(json["worldPath"].get_string().value());
+    chunkDeduplication = json["chunkDeduplication"].get_bool();
+    poolSlabSize = static_cast<uint32_t>(json["poolSlabSize"].get_uint64());
+    poolHugePages = json["poolHugePages"].get_bool();
     validationLayersEnabled = json["validationLayersEnabled"].get_bool();
+    debugTeleportEnabled = json["debugTeleportEnabled"].get_bool();
+
+    profilerReportPath = std::string(json["profilerReportPath"].get_string().value());
+    profilerReportInterval = json["profilerReportInterval"].get_double();
+    profilerOverlayEnabled = json["profilerOverlayEnabled"].get_bool();
+    worldProfileTickPath = std::string(json["worldProfileTickPath"].get_string().value());
+    worldProfileLatencyPath = std::string(json["worldProfileLatencyPath"].get_string().value());
 }
 catch (const simdjson::simdjson_error& e) {
-    GlobalLog.Write("Failed to load settings:");
-    GlobalLog.Write(e.what());
+    LOG_ERROR("Failed to load settings:");
+    LOG_ERROR(e.what());
 
     throw std::runtime_error("Failed to load settings");
 }
@@ -25,4 +40,18 @@ catch (const simdjson::simdjson_error& e) {
 
 uint32_t Settings::getLoadDistanceHorizontal() const { return loadDistanceHorizontal; }
 uint32_t Settings::getLoadDistanceVertical() const { return loadDistanceVertical; }
+uint32_t Settings::getUnloadMargin() const { return unloadMargin; }
+double Settings::getChunkPipelineBudgetMin() const { return chunkPipelineBudgetMin; }
+double Settings::getChunkPipelineBudgetMax() const { return chunkPipelineBudgetMax; }
+double Settings::getChunkPipelineTickReserve() const { return chunkPipelineTickReserve; }
+const std::string& Settings::getWorldPath() const { return worldPath; }
+bool Settings::getChunkDeduplication() const { return chunkDeduplication; }
+uint32_t Settings::getPoolSlabSize() const { return poolSlabSize; }
+bool Settings::getPoolHugePages() const { return poolHugePages; }
 bool Settings::getValidationLayersEnabled() const { return validationLayersEnabled; }
+bool Settings::getDebugTeleportEnabled() const { return debugTeleportEnabled; }
+const std::string& Settings::getProfilerReportPath() const { return profilerReportPath; }
+double Settings::getProfilerReportInterval() const { return profilerReportInterval; }
+bool Settings::getProfilerOverlayEnabled() const { return profilerOverlayEnabled; }
+const std::string& Settings::getWorldProfileTickPath() const { return worldProfileTickPath; }
+const std::string& Settings::getWorldProfileLatencyPath() const { return worldProfileLatencyPath; }
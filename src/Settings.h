@@ -8,8 +8,31 @@ class Settings {
 private:
     uint32_t loadDistanceHorizontal;
     uint32_t loadDistanceVertical;
+    // Extra distance in chunks beyond the load distance before chunks are unloaded
+    uint32_t unloadMargin;
+    // Milliseconds per tick which the chunk pipeline may spend
+    double chunkPipelineBudgetMin;
+    double chunkPipelineBudgetMax;
+    double chunkPipelineTickReserve;
+    // Directory which the region files are saved in
+    std::string worldPath;
+    // Share memory between chunks, and between meshes, with identical contents. Block texture rotations repeat every
+    // chunk when this is enabled, as they can't depend on the world position
+    bool chunkDeduplication;
+    // Bytes per slab of the chunk and block array pools, and whether to try to back the slabs with huge pages. The
+    // pool usage logged on exit shows how many slabs each pool needed.
+    uint32_t poolSlabSize;
+    bool poolHugePages;
 
     bool validationLayersEnabled;
+    // Pressing T teleports the player far enough away that the whole loaded area is dropped, for testing loading
+    bool debugTeleportEnabled;
+
+    std::string profilerReportPath;
+    double profilerReportInterval;
+    bool profilerOverlayEnabled;
+    std::string worldProfileTickPath;
+    std::string worldProfileLatencyPath;
 
 public:
     Settings();
@@ -20,5 +43,19 @@ public:
 
     uint32_t getLoadDistanceHorizontal() const;
     uint32_t getLoadDistanceVertical() const;
+    uint32_t getUnloadMargin() const;
+    double getChunkPipelineBudgetMin() const;
+    double getChunkPipelineBudgetMax() const;
+    double getChunkPipelineTickReserve() const;
+    const std::string& getWorldPath() const;
+    bool getChunkDeduplication() const;
+    uint32_t getPoolSlabSize() const;
+    bool getPoolHugePages() const;
     bool getValidationLayersEnabled() const;
+    bool getDebugTeleportEnabled() const;
+    const std::string& getProfilerReportPath() const;
+    double getProfilerReportInterval() const;
+    bool getProfilerOverlayEnabled() const;
+    const std::string& getWorldProfileTickPath() const;
+    const std::string& getWorldProfileLatencyPath() const;
 };
@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+
+/*
+Single writer sequence lock, for publishing a small value which is read far more often than it is written. Readers
+never block the writer, they instead retry if the value changed while they were copying it. The value is stored as
+relaxed atomic words, so that the copy racing with a write is still well defined.
+*/
+template <typename T>
+class SeqLock {
+	static_assert(std::is_trivially_copyable_v<T>, "SeqLock values are copied as raw words");
+
+private:
+	static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	// Odd while a write is in progress
+	std::atomic<uint32_t> sequence{0};
+	std::array<std::atomic<uint64_t>, WORD_COUNT> words{};
+
+public:
+	SeqLock() = default;
+	SeqLock(const T& value) { store(value); }
+
+	SeqLock(SeqLock&&) = delete;
+	SeqLock(const SeqLock&) = delete;
+	SeqLock operator=(SeqLock&&) = delete;
+	SeqLock operator=(const SeqLock&) = delete;
+
+	// Must only be called from one thread
+	void store(const T& value) {
+		std::array<uint64_t, WORD_COUNT> buffer{};
+		std::memcpy(buffer.data(), &value, sizeof(T));
+
+		uint32_t start = sequence.load(std::memory_order_relaxed);
+		sequence.store(start + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (size_t i = 0; i < WORD_COUNT; ++i) words[i].store(buffer[i], std::memory_order_relaxed);
+		sequence.store(start + 2, std::memory_order_release);
+	}
+
+	T load() const {
+		std::array<uint64_t, WORD_COUNT> buffer;
+		uint32_t start;
+		uint32_t end;
+		do {
+			start = sequence.load(std::memory_order_acquire);
+			for (size_t i = 0; i < WORD_COUNT; ++i) buffer[i] = words[i].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			end = sequence.load(std::memory_order_relaxed);
+		} while (start != end || start & 1);
+
+		T value;
+		std::memcpy(&value, buffer.data(), sizeof(T));
+		return value;
+	}
+};
@@ -1,8 +1,21 @@
 #include "SharedGameRendererState.h"
 
+#include "../Settings.h"
 
 
-SharedGameRendererState::SharedGameRendererState() :
-    chunkMeshQueue{std::make_shared<decltype(chunkMeshQueue)::element_type>()},
-    chunkMeshQueueDeletion{std::make_shared<decltype(chunkMeshQueueDeletion)::element_type>()}
+
+// Enough to hold a few seconds of meshing at the maximum rate, the world stops meshing when it fills up
+constexpr size_t CHUNK_MESH_QUEUE_CAPACITY = 1024;
+// Deletions are never throttled at the source, so this is sized to absorb the renderer dropping an entire load area
+constexpr size_t CHUNK_MESH_DELETION_QUEUE_CAPACITY = 16384;
+
+
+SharedGameRendererState::SharedGameRendererState(const Settings& settings) :
+    currentTick{0},
+    loadingProgress{1.0f},
+    chunkMeshQueue{std::make_shared<decltype(chunkMeshQueue)::element_type>(CHUNK_MESH_QUEUE_CAPACITY)},
+    chunkMeshQueueDeletion{
+        std::make_shared<decltype(chunkMeshQueueDeletion)::element_type>(CHUNK_MESH_DELETION_QUEUE_CAPACITY)
+    },
+    worldProfiler(settings.getWorldProfileTickPath(), settings.getWorldProfileLatencyPath())
 {}
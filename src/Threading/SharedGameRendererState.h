@@ -3,21 +3,39 @@
 #include <chrono>
 #include <memory>
 
+#include "SeqLock.h"
 #include "ThreadQueue.h"
+#include "../Profiling/WorldProfiler.h"
 #include "../Rendering/Mesh/MeshChunk.h"
 #include "../World/Entities/EntityPosition.h"
 class ChunkPos;
+class Settings;
+
+
+
+// Player state at the end of the two most recent ticks, the renderer draws somewhere in between the two
+struct PlayerSnapshot {
+    EntityPosition previous;
+    EntityPosition current;
+    // Scheduled start of the tick which produced current, and of the tick after it
+    std::chrono::steady_clock::time_point tickTimestamp;
+    std::chrono::steady_clock::time_point nextTickTimestamp;
+    std::chrono::steady_clock::time_point publishedTimestamp;
+};
 
 
 
 struct SharedGameRendererState {
+    // Published by the game thread at the end of every tick
     std::atomic_uint64_t currentTick;
-    std::chrono::steady_clock::time_point nextTickTimestamp;
+    SeqLock<PlayerSnapshot> playerSnapshot;
+    // Below one while the world is loading the area around the player after a teleport
+    std::atomic<float> loadingProgress;
 
     std::shared_ptr<ThreadQueue<std::unique_ptr<MeshChunk::Data>>> chunkMeshQueue;
 	std::shared_ptr<ThreadQueue<ChunkPos>> chunkMeshQueueDeletion;
 
-    std::atomic<EntityPosition> playerPosition;
+    WorldProfiler worldProfiler;
 
-    SharedGameRendererState();
+    SharedGameRendererState(const Settings& settings);
 };
@@ -0,0 +1,64 @@
+#include "SimulationClock.h"
+
+#include <algorithm>
+#include <thread>
+
+#include "../Profiling/Trace.h"
+
+
+
+SimulationClock::SimulationClock() : tickScheduled{Clock::now()}, tickBegin{tickScheduled} {}
+
+
+
+uint64_t SimulationClock::waitForTick() {
+    std::this_thread::sleep_until(tickScheduled);
+    tickBegin = Clock::now();
+
+    auto lateness = tickBegin - tickScheduled;
+    if (lateness > TICK_INTERVAL * MAX_CATCH_UP_TICKS) {
+        // Too far behind to catch up, so skip the missed ticks instead of running them back to back
+        statistics.droppedTicks += static_cast<uint64_t>(lateness / TICK_INTERVAL);
+        tickScheduled = tickBegin;
+    }
+
+    auto slip = std::chrono::duration_cast<std::chrono::microseconds>(tickBegin - tickScheduled);
+    statistics.maxSlip = std::max(statistics.maxSlip, slip);
+    statistics.totalSlip += slip;
+    TRACE_COUNTER("Tick slip (us)", slip.count());
+    return ++tick;
+}
+
+
+
+void SimulationClock::endTick() {
+    auto busy = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - tickBegin);
+    statistics.ticks++;
+    statistics.totalBusy += busy;
+    if (busy > TICK_INTERVAL) statistics.overBudgetTicks++;
+    tickScheduled += TICK_INTERVAL;
+}
+
+
+
+uint64_t SimulationClock::getTick() const {
+    return tick;
+}
+
+
+
+SimulationClock::Clock::time_point SimulationClock::getTickDeadline() const {
+    return tickScheduled + TICK_INTERVAL;
+}
+
+
+
+std::chrono::microseconds SimulationClock::getSlip() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(tickBegin - tickScheduled);
+}
+
+
+
+const SimulationClock::Statistics& SimulationClock::getStatistics() const {
+    return statistics;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+
+
+/*
+Fixed timestep scheduler for the game thread. Ticks are scheduled against the steady clock rather than against
+frames, so the world keeps its tick rate however long the renderer takes. When a tick starts late the following
+ticks run back to back to catch up, up to a limit, after which the missed ticks are dropped and the schedule is
+restarted from the current time.
+*/
+class SimulationClock {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::microseconds TICK_INTERVAL{20000};
+    static constexpr double TICK_SECONDS = std::chrono::duration<double>(TICK_INTERVAL).count();
+    // How far behind schedule the clock can fall before ticks are dropped
+    static constexpr uint32_t MAX_CATCH_UP_TICKS = 5;
+
+    struct Statistics {
+        uint64_t ticks;
+        uint64_t droppedTicks;
+        // Ticks which took longer than the tick interval to run
+        uint64_t overBudgetTicks;
+        std::chrono::microseconds maxSlip;
+        std::chrono::microseconds totalSlip;
+        std::chrono::microseconds totalBusy;
+    };
+
+private:
+    Clock::time_point tickScheduled;
+    Clock::time_point tickBegin;
+    // Ticks are numbered from one, zero means no tick has run yet
+    uint64_t tick = 0;
+    Statistics statistics{};
+
+public:
+    SimulationClock();
+
+    // Sleeps until the next tick is due and returns its number
+    uint64_t waitForTick();
+    // Marks the end of the work for the current tick
+    void endTick();
+
+    uint64_t getTick() const;
+    // The time by which the current tick should finish for the schedule to be kept
+    Clock::time_point getTickDeadline() const;
+    // How late the current tick started compared to its schedule
+    std::chrono::microseconds getSlip() const;
+    const Statistics& getStatistics() const;
+};
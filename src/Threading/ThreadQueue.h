@@ -1,35 +1,130 @@
 #pragma once
-#include <mutex>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
 #include <queue>
 
+#include "../Profiling/Trace.h"
 
 
+
+/*
+Bounded lock-free queue for handing batches of items from any number of producer threads to a single consumer
+thread. A producer claims a contiguous range of slots with a single compare and swap, fills them and publishes each
+one, and the consumer takes every published item in one go. Nothing ever blocks, when the queue is full the items
+that don't fit are left with the producer, which can use getFreeCapacity to avoid producing them in the first place.
+*/
 template <typename T>
 class ThreadQueue {
+public:
+	struct Counters {
+		// Number of times a producer lost the race to claim slots and had to retry
+		uint64_t contendedPushes;
+		// Number of merges which could not fit every item
+		uint64_t rejectedPushes;
+		size_t highWaterMark;
+	};
+
+private:
+	struct Slot {
+		// Set to position + 1 once the item for that position has been written
+		std::atomic<size_t> sequence{0};
+		alignas(T) std::byte storage[sizeof(T)];
+	};
+
+	size_t capacity;
+	std::unique_ptr<Slot[]> slots;
+
+	alignas(64) std::atomic<size_t> enqueuePosition{0};
+	// Only written by the consumer, once the items before it have been moved out of their slots
+	alignas(64) std::atomic<size_t> dequeuePosition{0};
+
+	alignas(64) std::atomic<uint64_t> contendedPushes{0};
+	std::atomic<uint64_t> rejectedPushes{0};
+	std::atomic<size_t> highWaterMark{0};
+
 private:
-	std::queue<T> internalQueue;
-	std::mutex queueMutex;
+	Slot& getSlot(size_t position) { return slots[position & (capacity - 1)]; }
 
 public:
+	// The capacity is rounded up to a power of two, so that positions can be masked into slot indices
+	ThreadQueue(size_t _capacity) : capacity{std::bit_ceil(_capacity)}, slots{new Slot[capacity]} {}
+
+	~ThreadQueue() {
+		std::queue<T> remaining;
+		getQueue(remaining);
+	}
+
+	ThreadQueue(ThreadQueue&&) = delete;
+	ThreadQueue(const ThreadQueue&) = delete;
+	ThreadQueue operator=(ThreadQueue&&) = delete;
+	ThreadQueue operator=(const ThreadQueue&) = delete;
+
+	// Consumer only, moves every published item onto the back of swapQueue
 	void getQueue(std::queue<T>& swapQueue) {
-		std::scoped_lock<std::mutex> lock(queueMutex);
-		if (!internalQueue.empty()) {
-			std::swap(internalQueue, swapQueue);
+		TRACE_ZONE("ThreadQueue::getQueue");
+		size_t position = dequeuePosition.load(std::memory_order_relaxed);
+		size_t start = position;
+		while (getSlot(position).sequence.load(std::memory_order_acquire) == position + 1) {
+			T* item = std::launder(reinterpret_cast<T*>(getSlot(position).storage));
+			swapQueue.push(std::move(*item));
+			item->~T();
+			position++;
 		}
+		if (position != start) dequeuePosition.store(position, std::memory_order_release);
 	}
 
-	void mergeQueue(std::queue<T>& mergeQueue) {
-		std::scoped_lock<std::mutex> lock(queueMutex);
-		// Simply exchange queues if the internal one is empty
-		if (internalQueue.empty()) {
-			std::swap(internalQueue, mergeQueue);
-		}
-		// Otherwise move items from mergeQueue to internalQueue
-		else {
-			while (!mergeQueue.empty()) {
-				internalQueue.push(std::move(mergeQueue.front()));
-				mergeQueue.pop();
+	// Moves as many items as fit from the front of mergeQueue, returns whether mergeQueue was emptied
+	bool mergeQueue(std::queue<T>& mergeQueue) {
+		TRACE_ZONE("ThreadQueue::mergeQueue");
+		TRACE_COUNTER("ThreadQueue merged items", mergeQueue.size());
+		if (mergeQueue.empty()) return true;
+
+		size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		size_t count;
+		while (true) {
+			size_t used = position - dequeuePosition.load(std::memory_order_acquire);
+			count = std::min(capacity - used, mergeQueue.size());
+			if (!count) {
+				rejectedPushes.fetch_add(1, std::memory_order_relaxed);
+				return false;
 			}
+			if (enqueuePosition.compare_exchange_weak(position, position + count, std::memory_order_relaxed)) break;
+			contendedPushes.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			Slot& slot = getSlot(position + i);
+			new (slot.storage) T(std::move(mergeQueue.front()));
+			mergeQueue.pop();
+			slot.sequence.store(position + i + 1, std::memory_order_release);
 		}
+
+		size_t occupancy = position + count - dequeuePosition.load(std::memory_order_relaxed);
+		size_t highWater = highWaterMark.load(std::memory_order_relaxed);
+		while (occupancy > highWater && !highWaterMark.compare_exchange_weak(highWater, occupancy));
+
+		if (!mergeQueue.empty()) rejectedPushes.fetch_add(1, std::memory_order_relaxed);
+		return mergeQueue.empty();
+	}
+
+	// Approximate when other threads are pushing or popping
+	size_t getSize() const {
+		size_t used = enqueuePosition.load(std::memory_order_relaxed) - dequeuePosition.load(std::memory_order_relaxed);
+		return std::min(used, capacity);
+	}
+
+	size_t getFreeCapacity() const { return capacity - getSize(); }
+	size_t getCapacity() const { return capacity; }
+
+	Counters getCounters() const {
+		return {
+			.contendedPushes = contendedPushes.load(std::memory_order_relaxed),
+			.rejectedPushes = rejectedPushes.load(std::memory_order_relaxed),
+			.highWaterMark = highWaterMark.load(std::memory_order_relaxed)
+		};
 	}
 };
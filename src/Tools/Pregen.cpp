@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../GlobalLog.h"
+#include "../Settings.h"
+#include "../World/Chunk.h"
+#include "../World/SlabPool.h"
+#include "../World/Generation/GeneratorChunkNoise.h"
+#include "../World/Generation/GeneratorChunkParameters.h"
+#include "../World/Storage/RegionStorage.h"
+
+
+
+namespace {
+
+/*
+The area is split into tiles with the horizontal footprint of a region, so every tile writes to its own region files
+and workers never share one. A tile generates one column of chunks beyond its edges, as population needs every
+neighbour to be generated, and heightmaps are computed once per column for the whole vertical range.
+*/
+struct Tile {
+	i32 regionX;
+	i32 regionZ;
+};
+
+
+
+struct PregenOptions {
+	i32 radius;
+	i32 minY;
+	i32 maxY;
+};
+
+
+
+struct PregenCounters {
+	std::atomic<u64> tilesDone{0};
+	std::atomic<u64> tilesSkipped{0};
+	std::atomic<u64> chunksGenerated{0};
+	std::atomic<u64> chunksWritten{0};
+	std::atomic<u64> populateMicroseconds{0};
+};
+
+
+
+bool columnInRadius(i32 x, i32 z, i32 radius) {
+	return i64{x} * x + i64{z} * z <= i64{radius} * radius;
+}
+
+
+
+// Tiles touching the area, nearest first, so that an interrupted run has finished the area around spawn
+std::vector<Tile> getTiles(i32 radius) {
+	std::vector<Tile> tiles;
+	const i32 regionRadius = (radius >> REGION_SIZE_LOG) + 1;
+	for (i32 regionX = -regionRadius; regionX <= regionRadius; ++regionX) {
+	for (i32 regionZ = -regionRadius; regionZ <= regionRadius; ++regionZ) {
+		const i32 nearestX = std::clamp(0, regionX * REGION_SIZE, regionX * REGION_SIZE + REGION_SIZE - 1);
+		const i32 nearestZ = std::clamp(0, regionZ * REGION_SIZE, regionZ * REGION_SIZE + REGION_SIZE - 1);
+		if (columnInRadius(nearestX, nearestZ, radius)) tiles.push_back({regionX, regionZ});
+	}
+	}
+	auto tileDistance = [](const Tile& tile) {
+		return i64{tile.regionX} * tile.regionX + i64{tile.regionZ} * tile.regionZ;
+	};
+	std::stable_sort(tiles.begin(), tiles.end(), [&](const Tile& a, const Tile& b) {
+		return tileDistance(a) < tileDistance(b);
+	});
+	return tiles;
+}
+
+
+
+void pregenerateTile(
+	const Tile& tile,
+	const PregenOptions& options,
+	GeneratorChunkNoise& noise,
+	const std::string& worldPath,
+	PregenCounters& counters
+) {
+	RegionStorage storage(worldPath);
+
+	// Chunks which are already stored are kept, as they may be checkpoints of edited chunks, and a tile where every
+	// chunk is stored was finished by an earlier run
+	std::vector<ChunkPos> pending;
+	for (i32 lX = 0; lX < REGION_SIZE; ++lX) {
+	for (i32 lZ = 0; lZ < REGION_SIZE; ++lZ) {
+		const i32 x = tile.regionX * REGION_SIZE + lX;
+		const i32 z = tile.regionZ * REGION_SIZE + lZ;
+		if (!columnInRadius(x, z, options.radius)) continue;
+		for (i32 y = options.minY; y <= options.maxY; ++y) {
+			if (!storage.hasChunk(ChunkPos(x, y, z))) pending.push_back(ChunkPos(x, y, z));
+		}
+	}
+	}
+	if (pending.empty()) {
+		counters.tilesSkipped++;
+		return;
+	}
+
+	std::unordered_map<ChunkPos, std::unique_ptr<Chunk>> chunks;
+	const i32 _minX = tile.regionX * REGION_SIZE - 1;
+	const i32 _minZ = tile.regionZ * REGION_SIZE - 1;
+	for (i32 x = _minX; x <= _minX + REGION_SIZE + 1; ++x) {
+	for (i32 z = _minZ; z <= _minZ + REGION_SIZE + 1; ++z) {
+		// Only columns next to one in the area are needed
+		bool needed = false;
+		for (i32 dX = -1; dX <= 1; ++dX) {
+		for (i32 dZ = -1; dZ <= 1; ++dZ) {
+			needed = needed || columnInRadius(x + dX, z + dZ, options.radius);
+		}
+		}
+		if (!needed) continue;
+
+		GeneratorChunkParameters parameters(ChunkPos2D(x, z), noise);
+		for (i32 y = options.minY - 1; y <= options.maxY + 1; ++y) {
+			auto chunk = std::make_unique<Chunk>(ChunkPos(x, y, z));
+			chunk->GenerateChunk(parameters);
+			chunks.emplace(ChunkPos(x, y, z), std::move(chunk));
+		}
+		counters.chunksGenerated += static_cast<u64>(options.maxY - options.minY + 3);
+	}
+	}
+
+	std::vector<u8> data;
+	for (const ChunkPos pos : pending) {
+		std::array<Chunk*, 26> neighbours{};
+		for (size_t i = 0; i < neighbours.size(); ++i) {
+			const auto [_dx, _dy, _dz] = CHUNK_NEIGHBOUR_OFFSETS[i];
+			neighbours[i] = chunks.at(ChunkPos(pos.getX() + _dx, pos.getY() + _dy, pos.getZ() + _dz)).get();
+		}
+		Chunk& chunk = *chunks.at(pos);
+		const auto timePopulateBegin = std::chrono::steady_clock::now();
+		chunk.PopulateChunk(neighbours);
+		counters.populateMicroseconds += static_cast<u64>(std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - timePopulateBegin
+		).count());
+
+		data.clear();
+		chunk.serialize(data);
+		if (!storage.writeChunk(pos, data)) throw std::runtime_error("Failed to write chunk");
+		counters.chunksWritten++;
+	}
+	// Synced once per tile rather than per chunk, an interrupted tile is redone from the chunks that were stored
+	if (!storage.sync()) throw std::runtime_error("Failed to sync region");
+	counters.tilesDone++;
+}
+
+
+
+constexpr std::pair<std::string_view, BIOME> BIOME_NAMES[] = {
+	{"desert", BIOME::DESERT},
+	{"desert_deep", BIOME::DESERT_DEEP},
+	{"forest_boreal", BIOME::FOREST_BOREAL},
+	{"forest_temperate", BIOME::FOREST_TEMPERATE},
+	{"rainforest", BIOME::RAINFOREST},
+	{"savannah", BIOME::SAVANNAH},
+	{"shrubland", BIOME::SHRUBLAND},
+	{"tundra", BIOME::TUNDRA}
+};
+
+
+
+/*
+Populates an 11x11 area of chunks, three chunks high around the surface of the centre column, with every column forced
+to one biome. Prints the best time of five runs, and a hash of the populated blocks to check that changes to population
+leave the output the same. Nothing is written to the world.
+*/
+void benchmarkPopulation(BIOME biome, ChunkPos2D centre, GeneratorChunkNoise& noise) {
+	constexpr i32 AREA_RADIUS = 5;
+	constexpr i32 RUN_COUNT = 5;
+
+	GeneratorChunkParameters centreParameters(centre, noise);
+	const i32 surfaceY = (centreParameters.getHeightMap().heightMax + 1) >> CHUNK_SIZE_LOG;
+	const i32 minX = centre.getX() - AREA_RADIUS;
+	const i32 maxX = centre.getX() + AREA_RADIUS;
+	const i32 minZ = centre.getZ() - AREA_RADIUS;
+	const i32 maxZ = centre.getZ() + AREA_RADIUS;
+
+	double bestMicroseconds = std::numeric_limits<double>::max();
+	u64 hash = 0;
+	for (i32 run = 0; run < RUN_COUNT; ++run) {
+		std::unordered_map<ChunkPos, std::unique_ptr<Chunk>> chunks;
+		for (i32 x = minX - 1; x <= maxX + 1; ++x) {
+		for (i32 z = minZ - 1; z <= maxZ + 1; ++z) {
+			GeneratorChunkParameters parameters(ChunkPos2D(x, z), noise);
+			parameters.overrideBiome(biome);
+			for (i32 y = surfaceY - 2; y <= surfaceY + 2; ++y) {
+				auto chunk = std::make_unique<Chunk>(ChunkPos(x, y, z));
+				chunk->GenerateChunk(parameters);
+				chunks.emplace(ChunkPos(x, y, z), std::move(chunk));
+			}
+		}
+		}
+
+		const auto timeBegin = std::chrono::steady_clock::now();
+		for (i32 x = minX; x <= maxX; ++x) {
+		for (i32 z = minZ; z <= maxZ; ++z) {
+		for (i32 y = surfaceY - 1; y <= surfaceY + 1; ++y) {
+			std::array<Chunk*, 26> neighbours{};
+			for (size_t i = 0; i < neighbours.size(); ++i) {
+				const auto [_dx, _dy, _dz] = CHUNK_NEIGHBOUR_OFFSETS[i];
+				neighbours[i] = chunks.at(ChunkPos(x + _dx, y + _dy, z + _dz)).get();
+			}
+			chunks.at(ChunkPos(x, y, z))->PopulateChunk(neighbours);
+		}
+		}
+		}
+		const double microseconds = std::chrono::duration<double, std::micro>(
+			std::chrono::steady_clock::now() - timeBegin
+		).count();
+		bestMicroseconds = std::min(bestMicroseconds, microseconds);
+
+		// FNV-1a over every populated block
+		hash = 14695981039346656037ull;
+		for (i32 x = minX; x <= maxX; ++x) {
+		for (i32 z = minZ; z <= maxZ; ++z) {
+		for (i32 y = surfaceY - 1; y <= surfaceY + 1; ++y) {
+			const Chunk& chunk = *chunks.at(ChunkPos(x, y, z));
+			for (i32 i = 0; i < CHUNK_VOLUME; ++i) {
+				hash ^= static_cast<u64>(chunk.getBlock(ChunkLocalBlockPos(static_cast<u16>(i))).blockType);
+				hash *= 1099511628211ull;
+			}
+		}
+		}
+		}
+	}
+
+	const i32 chunkCount = (2 * AREA_RADIUS + 1) * (2 * AREA_RADIUS + 1) * 3;
+	std::cout << "Populated " << chunkCount << " chunks in " << bestMicroseconds / chunkCount
+		<< "us per chunk, best of " << RUN_COUNT << " runs, block hash " << std::hex << hash << std::dec << '\n';
+}
+
+
+
+// revette_pregen --benchmark-population <biome> [<chunk x> <chunk z>]
+void runBenchmark(int argc, char** argv) {
+	if (argc != 3 && argc != 5) {
+		throw std::runtime_error("Usage: revette_pregen --benchmark-population <biome> [<chunk x> <chunk z>]");
+	}
+	const auto biome = std::ranges::find_if(BIOME_NAMES, [&](const auto& name) { return name.first == argv[2]; });
+	if (biome == std::end(BIOME_NAMES)) throw std::runtime_error(std::string("Unknown biome ") + argv[2]);
+	const ChunkPos2D centre(argc == 5 ? std::stoi(argv[3]) : 0, argc == 5 ? std::stoi(argv[4]) : 0);
+
+	GeneratorChunkNoise noise(WORLD_SEED, NOISE_HEIGHTMAP, NOISE_TEMPERATURE, NOISE_RAINFALL);
+	benchmarkPopulation(biome->second, centre, noise);
+}
+
+
+
+PregenOptions parseOptions(int argc, char** argv) {
+	if (argc != 2 && argc != 4) {
+		throw std::runtime_error("Usage: revette_pregen <radius> [<min chunk y> <max chunk y>]");
+	}
+	PregenOptions options{
+		.radius = std::stoi(argv[1]),
+		.minY = argc == 4 ? std::stoi(argv[2]) : -2,
+		.maxY = argc == 4 ? std::stoi(argv[3]) : 8
+	};
+	// Beyond this the world wraps around and the area would overlap itself
+	if (options.radius < 0 || options.radius >= WORLD_RADIUS_CHUNK) {
+		throw std::runtime_error("Radius must be between 0 and " + std::to_string(WORLD_RADIUS_CHUNK - 1));
+	}
+	if (options.minY > options.maxY) throw std::runtime_error("Minimum chunk y is above the maximum");
+	return options;
+}
+
+}
+
+
+
+// Generates and populates every chunk within a radius of spawn, and saves them to the world's region files so that the
+// game loads them instead of generating them. Interrupted runs continue where they left off. Must be run from the same
+// directory as the game. With --benchmark-population it only times population instead, see benchmarkPopulation.
+int main(int argc, char** argv) {
+	try {
+		if (argc >= 2 && std::string_view(argv[1]) == "--benchmark-population") {
+			runBenchmark(argc, argv);
+			return 0;
+		}
+		const PregenOptions options = parseOptions(argc, argv);
+		Settings settings;
+		SlabPool::configure(settings.getPoolSlabSize(), settings.getPoolHugePages());
+		GeneratorChunkNoise noise(WORLD_SEED, NOISE_HEIGHTMAP, NOISE_TEMPERATURE, NOISE_RAINFALL);
+
+		const std::vector<Tile> tiles = getTiles(options.radius);
+		PregenCounters counters;
+		std::atomic<size_t> nextTile{0};
+		std::atomic_bool failed{false};
+
+		const auto timeBegin = std::chrono::steady_clock::now();
+		{
+			const unsigned threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+			std::vector<std::jthread> workers;
+			workers.reserve(threadCount);
+			for (unsigned i = 0; i < threadCount; ++i) {
+				workers.emplace_back([&]() {
+					for (size_t tile = nextTile++; tile < tiles.size() && !failed; tile = nextTile++) {
+						try {
+							pregenerateTile(tiles[tile], options, noise, settings.getWorldPath(), counters);
+						}
+						catch (const std::exception& e) {
+							LOG_ERROR(std::string("Pregeneration failed: ") + e.what());
+							failed = true;
+						}
+					}
+				});
+			}
+
+			while (counters.tilesDone + counters.tilesSkipped < tiles.size() && !failed) {
+				std::this_thread::sleep_for(std::chrono::seconds(1));
+				const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - timeBegin).count();
+				std::cout << "\r" << counters.tilesDone + counters.tilesSkipped << "/" << tiles.size() << " tiles, "
+					<< static_cast<u64>(static_cast<double>(counters.chunksWritten) / seconds) << " chunks/s" << std::flush;
+			}
+		}
+
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - timeBegin).count();
+		std::cout << "\nWrote " << counters.chunksWritten << " chunks (" << counters.chunksGenerated << " generated) in "
+			<< seconds << "s, " << static_cast<double>(counters.chunksWritten) / seconds << " chunks/s, "
+			<< counters.tilesSkipped << " tiles already done\n";
+		if (counters.chunksWritten) {
+			std::cout << "Population took " << counters.populateMicroseconds / counters.chunksWritten
+				<< "us per chunk across all threads\n";
+		}
+		for (const auto& pool : SlabPool::getAllStats()) {
+			std::cout << pool.name << " pool: " << pool.slotsHighWater << " high water, " << pool.slotsReserved
+				<< " reserved in " << pool.slabCount << " slabs\n";
+		}
+		if (failed) {
+			std::cerr << "Pregeneration failed, see the log for details\n";
+			return 1;
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Failed to pregenerate world: " << e.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,26 @@
+#include <exception>
+#include <iostream>
+
+#include "../Rendering/BakedTexture.h"
+
+
+
+// Bakes every texture in res/textures, so that the game can copy them straight into a staging buffer at startup.
+// Must be run from the same directory as the game.
+int main() {
+	try {
+		for (const auto& source : TEXTURE_SOURCES) {
+			BakedTexture texture = bakeTexture(source);
+			writeBakedTexture(source.bakedPath, texture);
+			std::cout << source.sourcePath << " -> " << source.bakedPath << " ("
+				<< texture.header.layerCount << " layers, "
+				<< texture.header.mipLevelCount << " mips, "
+				<< texture.header.dataSize << " bytes)\n";
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Failed to bake textures: " << e.what() << '\n';
+		return 1;
+	}
+	return 0;
+}
@@ -22,8 +22,8 @@ BlockOffset::BlockOffset(i32 _x, i32 _y, i32 _z) :
 
 
 i32 BlockOffset::getX() const { return x; }
-i32 BlockOffset::getY() const { return x; }
-i32 BlockOffset::getZ() const { return x; }
+i32 BlockOffset::getY() const { return y; }
+i32 BlockOffset::getZ() const { return z; }
 
 
 
@@ -1,46 +1,67 @@
 #include "BlockContainer.h"
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cstring>
+#include <span>
+#include <type_traits>
 
 #include <boost/container/small_vector.hpp>
 
+#include "BlockRegistry.h"
+#include "SlabPool.h"
+#include "Storage/ByteStream.h"
 #include "../Exceptions.h"
 
 
 
 namespace {
 
-// This should ideally be stored in a physics engine lookup, but it works for now
-// TODO: move this to a physics engine
-const bool IS_SOLID[] = {
-	false,
-	true,
-	true,
-	true,
-	false,
-	true,
-	false,
-	true,
-	true,
-	true,
-	false,
-	true,
-	false,
-	true,
-	false,
-	false,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true,
-	true
-};
+// Block arrays of each width come from their own pool, as chunks churn through them constantly. The arrays aren't
+// initialised.
+template <typename T>
+std::shared_ptr<T[]> allocateBlockArray() {
+	static SlabPool pool(sizeof(T) == 1 ? "Block array (8 bit)" : "Block array (16 bit)", sizeof(T) * CHUNK_VOLUME);
+	return std::shared_ptr<T[]>(static_cast<T*>(pool.allocate()), [](T* array) { pool.deallocate(array); });
+}
+
+
+
+// Indices are packed so that none of them cross a word boundary, which keeps unpacking to a shift and a mask
+constexpr size_t packedWordCount(unsigned bitsPerIndex) {
+	const size_t indicesPerWord = 64 / bitsPerIndex;
+	return (CHUNK_VOLUME + indicesPerWord - 1) / indicesPerWord;
+}
+
+
+
+// Not cryptographic, only needs to spread the bits of every word across the whole hash
+u64 hashWords(const void* data, size_t size, u64 hash) {
+	constexpr u64 MULTIPLIER = 0x9e3779b97f4a7c15;
+	const auto* bytes = static_cast<const u8*>(data);
+	size_t i = 0;
+	for (; i + sizeof(u64) <= size; i += sizeof(u64)) {
+		u64 word;
+		std::memcpy(&word, bytes + i, sizeof(u64));
+		hash = std::rotl((hash ^ word) * MULTIPLIER, 29);
+	}
+	for (; i < size; ++i) hash = std::rotl((hash ^ bytes[i]) * MULTIPLIER, 29);
+	return hash ^ (hash >> 32);
+}
+
+
+
+template <typename T>
+void unpackIndices(std::span<const u64> packed, unsigned bitsPerIndex, size_t paletteSize, T* indices) {
+	const size_t indicesPerWord = 64 / bitsPerIndex;
+	const u64 mask = (u64{1} << bitsPerIndex) - 1;
+	for (size_t i = 0; i < CHUNK_VOLUME; ++i) {
+		const u64 index = (packed[i / indicesPerWord] >> ((i % indicesPerWord) * bitsPerIndex)) & mask;
+		if (index >= paletteSize) throw std::runtime_error("Stored block index is outside of the palette");
+		indices[i] = static_cast<T>(index);
+	}
+}
 
 }
 
@@ -58,27 +79,25 @@ void BlockContainer::setSingleBlock(Block block) {
 
 
 void BlockContainer::setSizeByte() {
-	if (std::holds_alternative<std::unique_ptr<uint8_t[]>>(blockArray)) {
+	if (std::holds_alternative<std::shared_ptr<uint8_t[]>>(blockArray)) {
 		return;
 	}
 
-	auto newArray = std::make_unique<uint8_t[]>(CHUNK_VOLUME);
+	auto newArray = allocateBlockArray<uint8_t>();
 	if (std::holds_alternative<Block>(blockArray)) {
 		Block _block = std::get<Block>(blockArray);
 		blockArrayBlocksByIndex.push_back(Block(0));
-		if (_block.blockType != 0) {
-			blockArrayBlocksByIndex.push_back(_block);
-			std::fill(newArray.get(), newArray.get() + CHUNK_VOLUME, 1u);
-		}
+		if (_block.blockType != 0) blockArrayBlocksByIndex.push_back(_block);
+		std::fill(newArray.get(), newArray.get() + CHUNK_VOLUME, _block.blockType != 0 ? 1u : 0u);
 	}
-	else if (std::holds_alternative<std::unique_ptr<uint16_t[]>>(blockArray)) {
+	else if (std::holds_alternative<std::shared_ptr<uint16_t[]>>(blockArray)) {
 		if (blockArrayBlocksByIndex.size() > 256) {
 			throw std::runtime_error("Cannot shrink block array to byte, too many blocks.");
 		}
-		auto& currentArray = std::get<std::unique_ptr<uint16_t[]>>(blockArray);
+		auto& currentArray = std::get<std::shared_ptr<uint16_t[]>>(blockArray);
 		std::transform(
 			currentArray.get(),
-			currentArray.get() + CHUNK_SIZE,
+			currentArray.get() + CHUNK_VOLUME,
 			newArray.get(),
 			[](uint16_t x) {
 				return static_cast<uint8_t>(x);
@@ -91,22 +110,20 @@ void BlockContainer::setSizeByte() {
 
 
 void BlockContainer::setSizeShort() {
-	if (std::holds_alternative<std::unique_ptr<uint16_t[]>>(blockArray)) {
+	if (std::holds_alternative<std::shared_ptr<uint16_t[]>>(blockArray)) {
 		return;
 	}
 
-	auto newArray = std::make_unique<uint16_t[]>(CHUNK_VOLUME);
+	auto newArray = allocateBlockArray<uint16_t>();
 	if (std::holds_alternative<Block>(blockArray)) {
 		Block _block = std::get<Block>(blockArray);
 		blockArrayBlocksByIndex.push_back(Block(0));
-		if (_block.blockType != 0) {
-			blockArrayBlocksByIndex.push_back(_block);
-			std::fill(newArray.get(), newArray.get() + CHUNK_VOLUME, 1u);
-		}
+		if (_block.blockType != 0) blockArrayBlocksByIndex.push_back(_block);
+		std::fill(newArray.get(), newArray.get() + CHUNK_VOLUME, _block.blockType != 0 ? 1u : 0u);
 	}
-	else if (std::holds_alternative<std::unique_ptr<uint8_t[]>>(blockArray)) {
-		auto& currentArray = std::get<std::unique_ptr<uint8_t[]>>(blockArray);
-		std::copy(currentArray.get(), currentArray.get() + CHUNK_SIZE, newArray.get());
+	else if (std::holds_alternative<std::shared_ptr<uint8_t[]>>(blockArray)) {
+		auto& currentArray = std::get<std::shared_ptr<uint8_t[]>>(blockArray);
+		std::copy(currentArray.get(), currentArray.get() + CHUNK_VOLUME, newArray.get());
 	}
 	blockArray = std::move(newArray);
 }
@@ -138,7 +155,7 @@ std::vector<bool> BlockContainer::getSolid() const {
 	if (std::holds_alternative<Block>(blockArray)) {
 		return std::vector<bool>(
 			CHUNK_VOLUME,
-			IS_SOLID[std::get<Block>(blockArray).blockType]
+			BlockRegistry::isSolid(std::get<Block>(blockArray))
 		);
 	}
 
@@ -149,7 +166,7 @@ std::vector<bool> BlockContainer::getSolid() const {
 		blockArrayBlocksByIndex.end(),
 		std::back_inserter(_indexTransparency),
 		[](Block b) -> bool {
-			return IS_SOLID[b.blockType];
+			return BlockRegistry::isSolid(b);
 		}
 	);
 	
@@ -158,14 +175,14 @@ std::vector<bool> BlockContainer::getSolid() const {
 	case 0:
 		break;
 	case 1: {
-		auto& _array = std::get<std::unique_ptr<uint8_t[]>>(blockArray);
+		const uint8_t* _array = std::get<std::shared_ptr<uint8_t[]>>(blockArray).get();
 		for (size_t i = 0; i < CHUNK_VOLUME; ++i) {
 			_solid[i] = _indexTransparency[_array[i]];
 		}
 		break;
 	}
 	case 2: {
-		auto& _array = std::get<std::unique_ptr<uint16_t[]>>(blockArray);
+		const uint16_t* _array = std::get<std::shared_ptr<uint16_t[]>>(blockArray).get();
 		for (size_t i = 0; i < CHUNK_VOLUME; ++i) {
 			_solid[i] = _indexTransparency[_array[i]];
 		}
@@ -180,7 +197,7 @@ std::vector<bool> BlockContainer::getSolid() const {
 
 std::vector<bool> BlockContainer::getSolidFace(AxisDirection direction) const {
 	if (std::holds_alternative<Block>(blockArray)) {
-		return std::vector<bool>(CHUNK_AREA, IS_SOLID[std::get<Block>(blockArray).blockType]);
+		return std::vector<bool>(CHUNK_AREA, BlockRegistry::isSolid(std::get<Block>(blockArray)));
 	}
 
 	boost::container::small_vector<bool, 64U> _indexTransparency;
@@ -190,13 +207,13 @@ std::vector<bool> BlockContainer::getSolidFace(AxisDirection direction) const {
 		blockArrayBlocksByIndex.end(),
 		std::back_inserter(_indexTransparency),
 		[](Block b) -> bool {
-			return IS_SOLID[b.blockType];
+			return BlockRegistry::isSolid(b);
 		}
 	);
 
 	std::vector<bool> _solid(CHUNK_AREA);
-	if (std::holds_alternative<std::unique_ptr<uint8_t[]>>(blockArray)) {
-		const auto& _array = std::get<std::unique_ptr<uint8_t[]>>(blockArray);
+	if (std::holds_alternative<std::shared_ptr<uint8_t[]>>(blockArray)) {
+		const auto& _array = std::get<std::shared_ptr<uint8_t[]>>(blockArray);
 
 		switch (direction) {
 		case AxisDirection::Up:
@@ -259,7 +276,7 @@ std::vector<bool> BlockContainer::getSolidFace(AxisDirection direction) const {
 	}
 	// uint16_t array
 	else {
-		auto& _array = std::get<std::unique_ptr<uint16_t[]>>(blockArray);
+		auto& _array = std::get<std::shared_ptr<uint16_t[]>>(blockArray);
 
 		switch (direction) {
 		case AxisDirection::Up:
@@ -328,18 +345,35 @@ std::vector<bool> BlockContainer::getSolidFace(AxisDirection direction) const {
 
 void BlockContainer::setBlock(ChunkLocalBlockPos blockPos, Block block) {
 	if (std::holds_alternative<Block>(blockArray)) setSizeByte();
-	setBlockRaw(blockPos.asIndex(), getOrAddPalleteIndex(block));
+	const uint16_t _blockIndex = getOrAddPalleteIndex(block);
+	unshareBlockArray();
+	setBlockRaw(blockPos.asIndex(), _blockIndex);
+}
+
+
+
+// Gives this container its own copy of the block array if any other container is using it
+void BlockContainer::unshareBlockArray() {
+	std::visit([&](auto& array) {
+		using ArrayType = std::decay_t<decltype(array)>;
+		if constexpr (!std::is_same_v<ArrayType, Block>) {
+			if (array.use_count() <= 1) return;
+			auto copy = allocateBlockArray<typename ArrayType::element_type>();
+			std::copy(array.get(), array.get() + CHUNK_VOLUME, copy.get());
+			array = std::move(copy);
+		}
+	}, blockArray);
 }
 
 
 
 // Directly sets the value in the block array, without any safety checks
 void BlockContainer::setBlockRaw(uint16_t arrayIndex, uint16_t blockIndex) {
-	if (std::holds_alternative<std::unique_ptr<uint8_t[]>>(blockArray)) {
-		std::get<std::unique_ptr<uint8_t[]>>(blockArray)[arrayIndex] = static_cast<uint8_t>(blockIndex);
+	if (std::holds_alternative<std::shared_ptr<uint8_t[]>>(blockArray)) {
+		std::get<std::shared_ptr<uint8_t[]>>(blockArray)[arrayIndex] = static_cast<uint8_t>(blockIndex);
 	}
-	else if (std::holds_alternative<std::unique_ptr<uint16_t[]>>(blockArray)) {
-		std::get<std::unique_ptr<uint16_t[]>>(blockArray)[arrayIndex] = blockIndex;
+	else if (std::holds_alternative<std::shared_ptr<uint16_t[]>>(blockArray)) {
+		std::get<std::shared_ptr<uint16_t[]>>(blockArray)[arrayIndex] = blockIndex;
 	}
 }
 
@@ -365,5 +399,134 @@ bool BlockContainer::isAir() const {
 
 
 bool BlockContainer::isSolid() const {
-	return std::holds_alternative<Block>(blockArray) && IS_SOLID[std::get<Block>(blockArray).blockType];
+	return std::holds_alternative<Block>(blockArray) && BlockRegistry::isSolid(std::get<Block>(blockArray));
+}
+
+
+
+u64 BlockContainer::getContentHash() const {
+	u64 _hash = blockArray.index();
+	if (std::holds_alternative<Block>(blockArray)) {
+		const Block _block = std::get<Block>(blockArray);
+		return hashWords(&_block, sizeof(Block), _hash);
+	}
+	_hash = hashWords(blockArrayBlocksByIndex.data(), blockArrayBlocksByIndex.size() * sizeof(Block), _hash);
+	std::visit([&](const auto& array) {
+		if constexpr (!std::is_same_v<std::decay_t<decltype(array)>, Block>) {
+			_hash = hashWords(array.get(), CHUNK_VOLUME * sizeof(array[0]), _hash);
+		}
+	}, blockArray);
+	return _hash;
+}
+
+
+
+bool BlockContainer::shareBlockArray(const BlockContainer& other) {
+	if (
+		std::holds_alternative<Block>(blockArray) ||
+		blockArray.index() != other.blockArray.index() ||
+		blockArrayBlocksByIndex != other.blockArrayBlocksByIndex
+	) {
+		return false;
+	}
+	bool _identical = std::visit([&](const auto& array) {
+		using ArrayType = std::decay_t<decltype(array)>;
+		if constexpr (std::is_same_v<ArrayType, Block>) return false;
+		else {
+			const auto& _otherArray = std::get<ArrayType>(other.blockArray);
+			return array == _otherArray || std::equal(array.get(), array.get() + CHUNK_VOLUME, _otherArray.get());
+		}
+	}, blockArray);
+	if (_identical) blockArray = other.blockArray;
+	return _identical;
+}
+
+
+
+size_t BlockContainer::getBlockArrayByteSize() const {
+	switch (blockArray.index()) {
+	case 1:
+		return CHUNK_VOLUME * sizeof(uint8_t);
+	case 2:
+		return CHUNK_VOLUME * sizeof(uint16_t);
+	default:
+		return 0;
+	}
+}
+
+
+
+void BlockContainer::encode(ByteWriter& writer) const {
+	if (std::holds_alternative<Block>(blockArray)) {
+		writer.write(u16{1});
+		writer.write(static_cast<i32>(std::get<Block>(blockArray).blockType));
+		writer.write(u8{0});
+		return;
+	}
+
+	// Blocks that have been overwritten can leave entries in the palette that are no longer used
+	std::vector<u16> indices(CHUNK_VOLUME);
+	std::visit([&](const auto& array) {
+		if constexpr (!std::is_same_v<std::decay_t<decltype(array)>, Block>) {
+			std::copy(array.get(), array.get() + CHUNK_VOLUME, indices.begin());
+		}
+	}, blockArray);
+	std::vector<u16> remap(blockArrayBlocksByIndex.size(), UINT16_MAX);
+	std::vector<Block> palette;
+	for (auto& index : indices) {
+		if (remap[index] == UINT16_MAX) {
+			remap[index] = static_cast<u16>(palette.size());
+			palette.push_back(blockArrayBlocksByIndex[index]);
+		}
+		index = remap[index];
+	}
+
+	writer.write(static_cast<u16>(palette.size()));
+	for (const Block block : palette) writer.write(static_cast<i32>(block.blockType));
+	if (palette.size() == 1) {
+		writer.write(u8{0});
+		return;
+	}
+
+	const auto bitsPerIndex = static_cast<unsigned>(std::bit_width(palette.size() - 1));
+	const size_t indicesPerWord = 64 / bitsPerIndex;
+	std::vector<u64> packed(packedWordCount(bitsPerIndex));
+	for (size_t i = 0; i < CHUNK_VOLUME; ++i) {
+		packed[i / indicesPerWord] |= u64{indices[i]} << ((i % indicesPerWord) * bitsPerIndex);
+	}
+	writer.write(static_cast<u8>(bitsPerIndex));
+	writer.writeArray(std::span<const u64>(packed));
+}
+
+
+
+void BlockContainer::decode(ByteReader& reader) {
+	const auto paletteSize = reader.read<u16>();
+	if (paletteSize == 0) throw std::runtime_error("Stored block palette is empty");
+	std::vector<Block> palette;
+	palette.reserve(paletteSize);
+	for (u16 i = 0; i < paletteSize; ++i) palette.push_back(Block(reader.read<i32>()));
+
+	const auto bitsPerIndex = reader.read<u8>();
+	if (paletteSize == 1) {
+		setSingleBlock(palette[0]);
+		return;
+	}
+	if (bitsPerIndex == 0 || bitsPerIndex > 16 || (size_t{1} << bitsPerIndex) < paletteSize) {
+		throw std::runtime_error("Stored block index size doesn't match the palette");
+	}
+
+	std::vector<u64> packed(packedWordCount(bitsPerIndex));
+	reader.readArray(std::span<u64>(packed));
+	if (paletteSize <= 256) {
+		auto indices = allocateBlockArray<uint8_t>();
+		unpackIndices(std::span<const u64>(packed), bitsPerIndex, paletteSize, indices.get());
+		blockArray = std::move(indices);
+	}
+	else {
+		auto indices = allocateBlockArray<uint16_t>();
+		unpackIndices(std::span<const u64>(packed), bitsPerIndex, paletteSize, indices.get());
+		blockArray = std::move(indices);
+	}
+	blockArrayBlocksByIndex = std::move(palette);
 }
@@ -5,14 +5,20 @@
 #include "AxisDirection.h"
 #include "Block.h"
 #include "ChunkPos.h"
+class ByteReader;
+class ByteWriter;
 
 
 
+// Block arrays can be shared between containers with identical contents, and are copied before one is written to
 class BlockContainer {
 public:
-	std::variant<Block, std::unique_ptr<uint8_t[]>, std::unique_ptr<uint16_t[]>> blockArray;
+	std::variant<Block, std::shared_ptr<uint8_t[]>, std::shared_ptr<uint16_t[]>> blockArray;
 	std::vector<Block> blockArrayBlocksByIndex;
 
+private:
+	void unshareBlockArray();
+
 public:
 	BlockContainer();
 
@@ -30,4 +36,14 @@ public:
 
 	bool isAir() const;
 	bool isSolid() const;
+
+	// Hash of the palette and block array, containers that can share their block array always hash the same
+	u64 getContentHash() const;
+	// Switches to the other container's block array if both hold exactly the same blocks, returning whether they did
+	bool shareBlockArray(const BlockContainer& other);
+	size_t getBlockArrayByteSize() const;
+
+	// Stored form of the blocks, the palette with unused entries removed followed by bit packed palette indices
+	void encode(ByteWriter& writer) const;
+	void decode(ByteReader& reader);
 };
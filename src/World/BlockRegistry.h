@@ -0,0 +1,108 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+#include "Core/RevetteCore.h"
+#include "Block.h"
+
+
+
+enum class BlockMeshType : u8 {
+	None,
+	Cube,
+	Cross,
+	Liquid
+};
+
+
+
+namespace BlockFlag {
+// Full opaque cube, which hides the faces of the blocks next to it
+constexpr u8 SOLID = 1 << 0;
+constexpr u8 COLLIDABLE = 1 << 1;
+// Textures are rotated by a hash of the block's position
+constexpr u8 ROTATABLE = 1 << 2;
+// The blocks behind it can be seen through it
+constexpr u8 TRANSPARENT = 1 << 3;
+constexpr u8 LIGHT_EMITTING = 1 << 4;
+}
+
+
+
+/*
+Properties of every block type, indexed by block type, which are defined once here and packed at compile time into
+a table per property. The tables have an entry for every block type that fits in a byte, and any block type beyond the
+registered ones reads the last entry, which has no flags and no mesh, so lookups never run past the end.
+*/
+namespace BlockRegistry {
+
+struct BlockProperties {
+	u8 flags;
+	BlockMeshType meshType;
+	// Texture of each face, in AxisDirection order
+	std::array<u16, 6> textures;
+};
+
+
+
+constexpr std::array<u16, 6> textures(u16 texture) {
+	return { texture, texture, texture, texture, texture, texture };
+}
+
+
+
+constexpr BlockProperties BLOCKS[] = {
+	{ BlockFlag::TRANSPARENT, BlockMeshType::None, textures(0) }, // 0
+	{ BlockFlag::SOLID | BlockFlag::COLLIDABLE | BlockFlag::ROTATABLE, BlockMeshType::Cube, textures(0) }, // 1
+	{ BlockFlag::SOLID | BlockFlag::COLLIDABLE | BlockFlag::ROTATABLE, BlockMeshType::Cube, textures(2) }, // 2
+	{ BlockFlag::SOLID | BlockFlag::COLLIDABLE, BlockMeshType::Cube, textures(3) }, // 3
+	{ BlockFlag::COLLIDABLE | BlockFlag::ROTATABLE | BlockFlag::TRANSPARENT, BlockMeshType::Cube, textures(4) }, // 4
+	{ BlockFlag::SOLID | BlockFlag::COLLIDABLE | BlockFlag::ROTATABLE, BlockMeshType::Cube, textures(5) }, // 5
+	{ BlockFlag::ROTATABLE | BlockFlag::TRANSPARENT, BlockMeshType::Liquid, textures(6) }, // 6
+	{ BlockFlag::SOLID | BlockFlag::COLLIDABLE | BlockFlag::ROTATABLE, BlockMeshType::Cube, textures(7) }, // 7
+	{ BlockFlag::SOLID | BlockFlag::COLLIDABLE | BlockFlag::ROTATABLE, BlockMeshType::Cube, textures(8) }, // 8
+	{ BlockFlag::SOLID | BlockFlag::COLLIDABLE, BlockMeshType::Cube, textures(9) }, // 9
+	{ BlockFlag::TRANSPARENT, BlockMeshType::Cross, textures(10) }, // 10
+	{ BlockFlag::SOLID | BlockFlag::COLLIDABLE | BlockFlag::ROTATABLE, BlockMeshType::Cube, textures(11) }, // 11
+	{ BlockFlag::ROTATABLE | BlockFlag::TRANSPARENT, BlockMeshType::Cube, textures(12) }, // 12
+	{ BlockFlag::SOLID | BlockFlag::COLLIDABLE, BlockMeshType::Cube, textures(13) }, // 13
+	{ BlockFlag::TRANSPARENT, BlockMeshType::Cross, textures(14) }, // 14
+	{ BlockFlag::COLLIDABLE | BlockFlag::ROTATABLE | BlockFlag::TRANSPARENT, BlockMeshType::Cube, textures(15) }, // 15
+	{ BlockFlag::SOLID | BlockFlag::COLLIDABLE | BlockFlag::ROTATABLE, BlockMeshType::Cube, textures(16) }, // 16
+	{ BlockFlag::SOLID | BlockFlag::COLLIDABLE | BlockFlag::ROTATABLE, BlockMeshType::Cube, textures(17) }, // 17
+	{ BlockFlag::SOLID | BlockFlag::COLLIDABLE | BlockFlag::ROTATABLE, BlockMeshType::Cube, textures(18) }, // 18
+};
+
+constexpr size_t TABLE_SIZE = 256;
+static_assert(std::size(BLOCKS) < TABLE_SIZE, "The last table entry is reserved for unknown block types");
+
+
+
+template <typename T, typename Property>
+constexpr std::array<T, TABLE_SIZE> buildTable(Property property) {
+	std::array<T, TABLE_SIZE> table{};
+	for (size_t i = 0; i < std::size(BLOCKS); ++i) table[i] = property(BLOCKS[i]);
+	return table;
+}
+
+constexpr auto FLAGS = buildTable<u8>([](const BlockProperties& block) { return block.flags; });
+constexpr auto MESH_TYPES = buildTable<BlockMeshType>([](const BlockProperties& block) { return block.meshType; });
+constexpr auto TEXTURES = buildTable<std::array<u16, 6>>([](const BlockProperties& block) { return block.textures; });
+
+
+
+// Index into the tables of a block type, unknown block types all share the last entry
+inline size_t getIndex(Block block) {
+	return std::min(static_cast<size_t>(static_cast<u32>(block.blockType)), TABLE_SIZE - 1);
+}
+
+inline bool hasFlag(Block block, u8 flag) { return FLAGS[getIndex(block)] & flag; }
+inline bool isSolid(Block block) { return hasFlag(block, BlockFlag::SOLID); }
+inline bool isCollidable(Block block) { return hasFlag(block, BlockFlag::COLLIDABLE); }
+inline bool isRotatable(Block block) { return hasFlag(block, BlockFlag::ROTATABLE); }
+inline BlockMeshType getMeshType(Block block) { return MESH_TYPES[getIndex(block)]; }
+// Textures of the six faces
+inline const u16* getTextures(Block block) { return TEXTURES[getIndex(block)].data(); }
+
+}
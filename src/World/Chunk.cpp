@@ -1,26 +1,113 @@
 #include "Chunk.h"
+#include <algorithm>
 #include <array>
+#include <bitset>
 #include <cassert>
+#include <cstdlib>
+#include <memory>
 #include <string>
+#include <utility>
 
-#include "BlockHash.h"
 #include "Generation/ChunkPRNG.h"
 #include "Generation/GeneratorChunkParameters.h"
 #include "Generation/Structures/StructurePlants.h"
 #include "Generation/Structures/StructuresRuins.h"
-#include "World.h"
+#include "SlabPool.h"
+#include "Storage/ByteStream.h"
 #include "../Exceptions.h"
 #include "../Math/ProbabilityTable.h"
 
 
 
+namespace {
+
+// The winning change to each block of the chunk being populated, where later changes only replace older ones. Kept per
+// thread and cleared through the list of written blocks, so that population doesn't allocate.
+struct PopulationScratch {
+	struct Change {
+		Block block;
+		u32 age;
+	};
+
+	std::array<Change, CHUNK_VOLUME> changes;
+	std::bitset<CHUNK_VOLUME> written;
+	std::vector<u16> dirty;
+
+	PopulationScratch() { dirty.reserve(CHUNK_VOLUME); }
+
+	void merge(std::span<const BlockChange> blockChanges) {
+		for (const auto& [_pos, _block, _age] : blockChanges) {
+			const u16 _index = ChunkLocalBlockPos(_pos).asIndex();
+			if (!written[_index]) {
+				written[_index] = true;
+				dirty.push_back(_index);
+				changes[_index] = { _block, _age };
+			}
+			else if (changes[_index].age < _age) changes[_index] = { _block, _age };
+		}
+	}
+
+	void clear() {
+		for (const u16 _index : dirty) written[_index] = false;
+		dirty.clear();
+	}
+};
+
+
+
+SlabPool& getChunkSlabPool() {
+	static SlabPool pool("Chunk", sizeof(Chunk));
+	return pool;
+}
+
+}
+
+
+
 inline i32 blockPositionIsInside(i32 x, i32 y, i32 z) {
 	return (x >= 0) && (x < CHUNK_SIZE) && (y >= 0) && (y < CHUNK_SIZE) && (z >= 0) && (z < CHUNK_SIZE);
 }
 
 
 
-Chunk::Chunk(ChunkPos _pos) : generated{ false }, position(_pos) {}
+void* Chunk::operator new(size_t size) {
+	assert(size == sizeof(Chunk));
+	return getChunkSlabPool().allocate();
+}
+
+
+
+void Chunk::operator delete(void* chunk) {
+	getChunkSlabPool().deallocate(chunk);
+}
+
+
+
+Chunk::Chunk(ChunkPos _pos) : generated{ false }, populationChangesReleased{ 0 }, position(_pos) {}
+
+
+
+// The population vectors keep their capacity, so a reused chunk doesn't have to grow them again
+void Chunk::reset(ChunkPos _pos) {
+	generated = false;
+	position = _pos;
+	blockContainer.setSingleBlock(Block(0));
+	for (auto& _bucket : populationChangesAdjacent) _bucket.clear();
+	populationChangesInside.clear();
+	populationChangesReleased = 0;
+}
+
+
+
+// Chunks entirely above the terrain and the sea are air, and chunks entirely below the terrain are stone. Neither gets
+// any population features.
+std::optional<Block> Chunk::getUniformGeneration(ChunkPos pos, const GeneratorChunkParameters& parameters) {
+	const i32 _chunkBottom = pos.getY() * CHUNK_SIZE;
+	const i32 _chunkTop = _chunkBottom + CHUNK_SIZE - 1;
+	if (parameters.heightMap.heightMax + 1 < _chunkBottom && _chunkBottom > SEA_LEVEL) return Block(0);
+	if (_chunkTop < parameters.heightMap.heightMin) return Block(2);
+	return std::nullopt;
+}
 
 
 
@@ -29,15 +116,14 @@ void Chunk::GenerateChunk(const GeneratorChunkParameters& genParameters) {
 	generated = true;
 
 	const i32 _chunkBottom = position.getY() * CHUNK_SIZE;
-	const i32 _chunkTop = _chunkBottom + CHUNK_SIZE - 1;
-
-	// Return if all of the chunk falls above the terrain height
-	if (genParameters.heightMap.heightMax + 1 < _chunkBottom && _chunkBottom > SEA_LEVEL) return;
 
-	// Fill the chunk if all of the chunk falls below the terrain height
+	// Return if all of the chunk falls above the terrain height, or fill the chunk if all of the chunk falls below it
 	// This code is sort of horrible, but it runs hella fast compared to what was here before
 	// Nvm this code is now even faster, and also looks okay
-	if (_chunkTop < genParameters.heightMap.heightMin) blockContainer.setSingleBlock(Block(2));
+	if (auto _uniformBlock = getUniformGeneration(position, genParameters)) {
+		blockContainer.setSingleBlock(*_uniformBlock);
+		return;
+	}
 	else
 	{
 		// Some blocks must be placed beyond this point, so this optimisation is valid
@@ -100,7 +186,17 @@ void Chunk::GenerateChunk(const GeneratorChunkParameters& genParameters) {
 		}
 	}
 
-	// Create population features
+	generatePopulationChanges(genParameters);
+}
+
+
+
+// Population features only depend on the chunk's position and generator parameters, so the changes can be generated
+// again for a chunk that has already handed them off
+void Chunk::generatePopulationChanges(const GeneratorChunkParameters& genParameters) {
+	const i32 _chunkBottom = position.getY() * CHUNK_SIZE;
+	const i32 _chunkTop = _chunkBottom + CHUNK_SIZE - 1;
+
 	// Return if chunk is entirely below surface or if all the surface air blocks are also below this chunk
 	if (_chunkTop <= genParameters.heightMap.heightMin || genParameters.heightMap.heightMax + 1 < _chunkBottom) return;
 
@@ -211,64 +307,99 @@ void Chunk::GenerateChunk(const GeneratorChunkParameters& genParameters) {
 	}
 
 	populationChangesInside.shrink_to_fit();
-	populationChangesAdjacent.shrink_to_fit();
+	for (auto& _bucket : populationChangesAdjacent) _bucket.shrink_to_fit();
+}
+
+
+
+// The changes are generated into a separate chunk, as this one may not have populated yet and still needs its own
+// changes, and the other neighbours which took theirs won't take them again
+void Chunk::regeneratePopulationChanges(const GeneratorChunkParameters& generatorParameters, size_t neighbourIndex) {
+	Chunk _generated(position);
+	_generated.generatePopulationChanges(generatorParameters);
+	populationChangesAdjacent[neighbourIndex] = std::move(_generated.populationChangesAdjacent[neighbourIndex]);
+	populationChangesReleased &= ~(1u << neighbourIndex);
 }
 
 
 
-void Chunk::PopulateChunk(World& world)
+void Chunk::fillUniform(Block block) {
+	if (generated) throw EXCEPTION_WORLD::ChunkRegeneration("Attempted to re-generate chunk");
+	generated = true;
+	blockContainer.setSingleBlock(block);
+}
+
+
+
+void Chunk::PopulateChunk(const std::array<Chunk*, 26>& neighbours)
 {
-	const i32 CHUNK_NEIGHBOURS[26][3] = {
-		{-1, -1, -1},
-		{-1, -1,  0},
-		{-1, -1,  1},
-		{-1,  0, -1},
-		{-1,  0,  0},
-		{-1,  0,  1},
-		{-1,  1, -1},
-		{-1,  1,  0},
-		{-1,  1,  1},
-		{ 0, -1, -1},
-		{ 0, -1,  0},
-		{ 0, -1,  1},
-		{ 0,  0, -1},
-		{ 0,  0,  1},
-		{ 0,  1, -1},
-		{ 0,  1,  0},
-		{ 0,  1,  1},
-		{ 1, -1, -1},
-		{ 1, -1,  0},
-		{ 1, -1,  1},
-		{ 1,  0, -1},
-		{ 1,  0,  0},
-		{ 1,  0,  1},
-		{ 1,  1, -1},
-		{ 1,  1,  0},
-		{ 1,  1,  1}
-	};
+	thread_local std::unique_ptr<PopulationScratch> _scratch;
+	if (!_scratch) _scratch = std::make_unique<PopulationScratch>();
+	// Cleared first as well, in case the last chunk populated on this thread threw part way through
+	_scratch->clear();
+	_scratch->merge(populationChangesInside);
+
+	// Take the changes each neighbour made to this chunk, which it is facing from the opposite side
+	for (size_t i = 0; i < neighbours.size(); ++i) {
+		const auto [_dx, _dy, _dz] = CHUNK_NEIGHBOUR_OFFSETS[i];
+		_scratch->merge(neighbours[i]->takePopulationChanges(getNeighbourIndex(-_dx, -_dy, -_dz)));
+	}
 
-	// Sort out changes based on age
-	std::unordered_map<BlockPos, std::pair<Block, unsigned>> _changes;
-	for (const auto& [_pos, _block, _age] : populationChangesInside) {
-		if (!_changes.contains(_pos) || _changes.at(_pos).second < _age) {
-			_changes[_pos] = { _block, _age };
-		}
+	for (const u16 _index : _scratch->dirty) {
+		const auto& [_block, _age] = _scratch->changes[_index];
+		const ChunkLocalBlockPos _localPos(_index);
+		if (_age > 1024 || getBlock(_localPos).blockType == 0) setBlock(_localPos, _block);
+	}
+	_scratch->clear();
+
+	std::vector<BlockChange>().swap(populationChangesInside);
+}
+
+
+
+// The changes this chunk makes to its neighbours are stored along with the blocks, as neighbours that are generated
+// later still need them to populate
+void Chunk::serialize(std::vector<u8>& data) const {
+	ByteWriter writer(data);
+	blockContainer.encode(writer);
+	u32 _changeCount = 0;
+	for (const auto& _bucket : populationChangesAdjacent) _changeCount += static_cast<u32>(_bucket.size());
+	writer.write(_changeCount);
+	for (const auto& _bucket : populationChangesAdjacent) {
+	for (const auto& [_pos, _block, _age] : _bucket) {
+		writer.write(_pos.getX());
+		writer.write(_pos.getY());
+		writer.write(_pos.getZ());
+		writer.write(static_cast<i32>(_block.blockType));
+		writer.write(_age);
 	}
+	}
+}
+
+
+
+void Chunk::deserialize(std::span<const u8> data) {
+	if (generated) throw EXCEPTION_WORLD::ChunkRegeneration("Attempted to load already generated chunk");
 
-	// Get changes from neighbours
-	for (const auto [lX, lY, lZ] : CHUNK_NEIGHBOURS) {
-		world.getChunk(ChunkPos(position.getX() + lX, position.getY() + lY, position.getZ() + lZ))->
-			addAdjacentPopulationChanges(_changes, position);
+	ByteReader reader(data);
+	blockContainer.decode(reader);
+	const auto _changeCount = reader.read<u32>();
+	for (u32 i = 0; i < _changeCount; ++i) {
+		const auto _x = reader.read<i32>();
+		const auto _y = reader.read<i32>();
+		const auto _z = reader.read<i32>();
+		const auto _block = reader.read<i32>();
+		setBlockPopulation(BlockPos(_x, _y, _z), Block(_block), reader.read<u32>());
 	}
+	if (!reader.empty()) throw std::runtime_error("Stored chunk has trailing data");
 
-	for (const auto& [_pos, _change] : _changes) {
-		const ChunkLocalBlockPos _localPos(_pos);
-		if (ChunkPos(_pos) == position && (_change.second > 1024 || getBlock(_localPos).blockType == 0)) {
-			setBlock(_localPos, _change.first);
-		}
+	// The stored changes don't say which neighbours had already taken theirs, so any empty bucket may have been
+	// released and is regenerated if a neighbour asks for it
+	for (size_t i = 0; i < populationChangesAdjacent.size(); ++i) {
+		if (populationChangesAdjacent[i].empty()) populationChangesReleased |= 1u << i;
 	}
 
-	populationChangesInside.clear();
+	generated = true;
 }
 
 
@@ -297,20 +428,77 @@ bool Chunk::shouldSkipMeshing() const {
 
 
 
+ChunkPos Chunk::getPosition() const {
+	return position;
+}
+
+
+
+std::optional<Block> Chunk::getUniformBlock() const {
+	if (
+		!std::holds_alternative<Block>(blockContainer.blockArray) ||
+		populationChangesReleased ||
+		!populationChangesInside.empty() ||
+		std::ranges::any_of(populationChangesAdjacent, [](const auto& bucket) { return !bucket.empty(); })
+	) {
+		return std::nullopt;
+	}
+	return std::get<Block>(blockContainer.blockArray);
+}
+
+
+
+u64 Chunk::getContentHash() const {
+	return blockContainer.getContentHash();
+}
+
+
+
+bool Chunk::shareBlocks(const Chunk& other) {
+	return blockContainer.shareBlockArray(other.blockContainer);
+}
+
+
+
+size_t Chunk::getBlockArrayByteSize() const {
+	return blockContainer.getBlockArrayByteSize();
+}
+
+
+
 void Chunk::setBlockPopulation(BlockPos blockPos, Block block, u32 age) {
-	if (ChunkPos(blockPos) == position) populationChangesInside.push_back({ blockPos, block, age });
-	else populationChangesAdjacent.push_back({ blockPos, block, age });
+	const ChunkOffset _offset = position.offset(ChunkPos(blockPos));
+	const i32 _dx = _offset.getX();
+	const i32 _dy = _offset.getY();
+	const i32 _dz = _offset.getZ();
+	if (!_dx && !_dy && !_dz) populationChangesInside.push_back({ blockPos, block, age });
+	// Changes beyond the neighbouring chunks could never be applied
+	else if (std::abs(_dx) <= 1 && std::abs(_dy) <= 1 && std::abs(_dz) <= 1) {
+		populationChangesAdjacent[getNeighbourIndex(_dx, _dy, _dz)].push_back({ blockPos, block, age });
+	}
 }
 
 
 
-void Chunk::addAdjacentPopulationChanges(
-	std::unordered_map<BlockPos, std::pair<Block, u32>>& changes,
-	ChunkPos pos
-) const {
-	for (auto& _change : populationChangesAdjacent)
-		if (_change.pos == pos && (!changes.contains(_change.pos) || changes.at(_change.pos).second < _change.age))
-			changes[_change.pos] = { _change.block, _change.age };
+bool Chunk::hasReleasedPopulationChanges(size_t neighbourIndex) const {
+	return populationChangesReleased & (1u << neighbourIndex);
 }
 
 
+
+size_t Chunk::getPopulationChangesByteSize() const {
+	size_t _capacity = populationChangesInside.capacity();
+	for (const auto& _bucket : populationChangesAdjacent) _capacity += _bucket.capacity();
+	return _capacity * sizeof(BlockChange);
+}
+
+
+
+// The bucket is freed once taken, as the neighbour only populates once. Buckets that were empty are left alone, which
+// also keeps the shared uniform chunks untouched.
+std::vector<BlockChange> Chunk::takePopulationChanges(size_t neighbourIndex) {
+	auto& _bucket = populationChangesAdjacent[neighbourIndex];
+	if (_bucket.empty()) return {};
+	populationChangesReleased |= 1u << neighbourIndex;
+	return std::exchange(_bucket, {});
+}
@@ -1,5 +1,8 @@
 #pragma once
+#include <array>
 #include <memory>
+#include <optional>
+#include <span>
 #include <unordered_map>
 #include <vector>
 
@@ -10,6 +13,46 @@
 
 
 
+// Offsets of the neighbours which are passed to PopulateChunk, in the order they are passed
+constexpr i32 CHUNK_NEIGHBOUR_OFFSETS[26][3] = {
+	{-1, -1, -1},
+	{-1, -1,  0},
+	{-1, -1,  1},
+	{-1,  0, -1},
+	{-1,  0,  0},
+	{-1,  0,  1},
+	{-1,  1, -1},
+	{-1,  1,  0},
+	{-1,  1,  1},
+	{ 0, -1, -1},
+	{ 0, -1,  0},
+	{ 0, -1,  1},
+	{ 0,  0, -1},
+	{ 0,  0,  1},
+	{ 0,  1, -1},
+	{ 0,  1,  0},
+	{ 0,  1,  1},
+	{ 1, -1, -1},
+	{ 1, -1,  0},
+	{ 1, -1,  1},
+	{ 1,  0, -1},
+	{ 1,  0,  0},
+	{ 1,  0,  1},
+	{ 1,  1, -1},
+	{ 1,  1,  0},
+	{ 1,  1,  1}
+};
+
+
+
+// Index into CHUNK_NEIGHBOUR_OFFSETS of the neighbour at an offset, the centre has no index
+constexpr size_t getNeighbourIndex(i32 dx, i32 dy, i32 dz) {
+	const auto _index = static_cast<size_t>((dx + 1) * 9 + (dy + 1) * 3 + (dz + 1));
+	return _index < 13 ? _index : _index - 1;
+}
+
+
+
 struct BlockChange {
 	BlockPos pos;
 	Block block{Block(0)};
@@ -23,9 +66,12 @@ class Chunk
 private:
 	bool generated;
 	BlockContainer blockContainer;
-	std::vector<BlockChange> populationChangesAdjacent;
+	// Changes to each neighbour, indexed like CHUNK_NEIGHBOUR_OFFSETS, and freed once handed over as it populates
+	std::array<std::vector<BlockChange>, 26> populationChangesAdjacent;
 	std::vector<BlockChange> populationChangesInside;
-	const ChunkPos position;
+	// Bit per neighbour whose changes have been freed, and have to be regenerated if it populates again
+	u32 populationChangesReleased;
+	ChunkPos position;
 
 public:
 	Chunk(ChunkPos _pos);
@@ -35,18 +81,50 @@ public:
 	Chunk operator=(Chunk&&) = delete;
 	Chunk operator=(const Chunk&) = delete;
 
+	// Chunk objects come from a SlabPool rather than the heap
+	static void* operator new(size_t size);
+	static void operator delete(void* chunk);
+
+	// Frees the block storage and population changes, leaving an ungenerated chunk at the given position
+	void reset(ChunkPos _pos);
+
+	// The block filling a chunk generated at the position, if it is a single block with nothing to populate
+	static std::optional<Block> getUniformGeneration(ChunkPos pos, const class GeneratorChunkParameters& parameters);
 	void GenerateChunk(const class GeneratorChunkParameters& generatorParameters);
-	void PopulateChunk(class World& world);
+	// Makes this a generated chunk made entirely of one block
+	void fillUniform(Block block);
+	// Applies the population changes made by this chunk and its neighbours, which must all be generated and have their
+	// changes for this chunk, see hasReleasedPopulationChanges
+	void PopulateChunk(const std::array<Chunk*, 26>& neighbours);
+	// Generates the changes to the neighbour with the index again, after they were freed
+	void regeneratePopulationChanges(const class GeneratorChunkParameters& generatorParameters, size_t neighbourIndex);
+	// Stored chunks are complete, so they skip both generation and population
+	void serialize(std::vector<u8>& data) const;
+	void deserialize(std::span<const u8> data);
 
 	Block getBlock(ChunkLocalBlockPos blockPos) const;
 	std::vector<bool> getSolidFaceMask(AxisDirection direction) const;
 	void setBlock(ChunkLocalBlockPos blockPos, Block block);
 	void setBlockPopulation(BlockPos blockPos, Block block, u32 age);
 	bool shouldSkipMeshing() const;
+	ChunkPos getPosition() const;
+	// The block filling this chunk, if it is a single block and has no population changes left for any chunk
+	std::optional<Block> getUniformBlock() const;
+	// Whether the changes to the neighbour with the index have been freed
+	bool hasReleasedPopulationChanges(size_t neighbourIndex) const;
+	// Memory held by population changes that haven't been applied yet
+	size_t getPopulationChangesByteSize() const;
+
+	// Chunks holding exactly the same blocks can share their block storage, see BlockContainer
+	u64 getContentHash() const;
+	bool shareBlocks(const Chunk& other);
+	size_t getBlockArrayByteSize() const;
 
 private:
-	void addAdjacentPopulationChanges(std::unordered_map<BlockPos, std::pair<Block, u32>>& changes, ChunkPos pos) const;
+	void generatePopulationChanges(const class GeneratorChunkParameters& genParameters);
+	std::vector<BlockChange> takePopulationChanges(size_t neighbourIndex);
 
 	friend class Structure;
 	friend class MeshChunk;
+	friend class ChunkNeighbourhood;
 };
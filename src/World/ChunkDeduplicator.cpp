@@ -0,0 +1,76 @@
+#include "ChunkDeduplicator.h"
+#include <algorithm>
+
+#include "../Profiling/Trace.h"
+
+
+
+constexpr size_t MINIMUM_SWEEP_SIZE = 4096;
+
+
+
+ChunkDeduplicator::ChunkDeduplicator(bool _enabled) :
+	enabled{_enabled},
+	chunkSweepSize{MINIMUM_SWEEP_SIZE},
+	geometrySweepSize{MINIMUM_SWEEP_SIZE}
+{}
+
+
+
+void ChunkDeduplicator::deduplicateBlocks(
+	Chunk& chunk,
+	const std::unordered_map<ChunkPos, std::unique_ptr<Chunk>>& chunks
+) {
+	// Chunks made of a single block have no storage to share
+	if (!enabled || !chunk.getBlockArrayByteSize()) return;
+	TRACE_ZONE("ChunkDeduplicator::deduplicateBlocks");
+	stats.chunkLookups++;
+
+	const ChunkPos _position = chunk.getPosition();
+	auto [_entry, _inserted] = chunksByHash.try_emplace(chunk.getContentHash(), _position);
+	if (!_inserted && _entry->second != _position) {
+		auto _other = chunks.find(_entry->second);
+		if (_other != chunks.end() && chunk.shareBlocks(*_other->second)) {
+			stats.chunkHits++;
+			stats.blockBytesSaved += chunk.getBlockArrayByteSize();
+			return;
+		}
+		// The recorded chunk is gone or no longer matches, so this one takes its place
+		_entry->second = _position;
+	}
+
+	if (chunksByHash.size() > chunkSweepSize) {
+		std::erase_if(chunksByHash, [&](const auto& entry) { return !chunks.contains(entry.second); });
+		chunkSweepSize = std::max(chunksByHash.size() * 2, MINIMUM_SWEEP_SIZE);
+	}
+}
+
+
+
+std::unique_ptr<MeshChunk::Data> ChunkDeduplicator::createMesh(
+	const Chunk* chunkCentre,
+	const std::array<Chunk*, 6>& neighbours
+) {
+	if (!enabled) return std::make_unique<MeshChunk::Data>(chunkCentre, neighbours);
+	stats.meshLookups++;
+
+	auto& _cached = geometryByKey[MeshChunk::Data::getGeometryKey(chunkCentre, neighbours)];
+	if (auto _geometry = _cached.lock()) {
+		stats.meshHits++;
+		stats.meshBytesSaved += _geometry->vertices.size() * sizeof(MeshChunk::Vertex);
+		stats.meshBytesSaved += _geometry->indices.size() * sizeof(uint32_t);
+		return std::make_unique<MeshChunk::Data>(chunkCentre->getPosition(), std::move(_geometry));
+	}
+	auto meshData = std::make_unique<MeshChunk::Data>(chunkCentre, neighbours, true);
+	_cached = meshData->getGeometry();
+
+	if (geometryByKey.size() > geometrySweepSize) {
+		std::erase_if(geometryByKey, [](const auto& entry) { return entry.second.expired(); });
+		geometrySweepSize = std::max(geometryByKey.size() * 2, MINIMUM_SWEEP_SIZE);
+	}
+	return meshData;
+}
+
+
+
+const ChunkDeduplicator::Stats& ChunkDeduplicator::getStats() const { return stats; }
@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <unordered_map>
+
+#include "Chunk.h"
+#include "../Rendering/Mesh/MeshChunk.h"
+
+
+
+/*
+Lets loaded chunks with identical blocks share their block storage, and chunks that would build identical meshes share
+the mesh geometry, which the renderer then uploads once. Chunks are found by a hash of their contents and compared in
+full before sharing, as edits can change a chunk after it was recorded. Meshes are found by their geometry key alone.
+When disabled every chunk keeps its own storage and meshes are built as usual.
+*/
+class ChunkDeduplicator {
+public:
+	struct Stats {
+		u64 chunkLookups = 0;
+		u64 chunkHits = 0;
+		u64 blockBytesSaved = 0;
+		u64 meshLookups = 0;
+		u64 meshHits = 0;
+		u64 meshBytesSaved = 0;
+	};
+
+private:
+	bool enabled;
+	// A chunk with each content hash, which may since have been unloaded or edited
+	std::unordered_map<u64, ChunkPos> chunksByHash;
+	std::unordered_map<u64, std::weak_ptr<const MeshChunk::Geometry>> geometryByKey;
+	// Stale entries are removed once the maps grow past these sizes
+	size_t chunkSweepSize;
+	size_t geometrySweepSize;
+	Stats stats;
+
+public:
+	ChunkDeduplicator(bool _enabled);
+
+	ChunkDeduplicator(ChunkDeduplicator&&) = delete;
+	ChunkDeduplicator(const ChunkDeduplicator&) = delete;
+	ChunkDeduplicator operator=(ChunkDeduplicator&&) = delete;
+	ChunkDeduplicator operator=(const ChunkDeduplicator&) = delete;
+
+	// Shares the chunk's block storage with a loaded chunk holding the same blocks, if there is one
+	void deduplicateBlocks(Chunk& chunk, const std::unordered_map<ChunkPos, std::unique_ptr<Chunk>>& chunks);
+	// Reuses the geometry of a live mesh with the same key, otherwise builds the mesh
+	std::unique_ptr<MeshChunk::Data> createMesh(const Chunk* chunkCentre, const std::array<Chunk*, 6>& neighbours);
+
+	const Stats& getStats() const;
+};
@@ -0,0 +1,53 @@
+#include "ChunkLoadOrder.h"
+#include <algorithm>
+#include <cassert>
+
+
+
+ChunkLoadOrder::ChunkLoadOrder(uint32_t radiusHorizontal, uint32_t radiusVertical) : centre(0, 0, 0) {
+	const i32 horizontal = static_cast<i32>(radiusHorizontal);
+	const i32 vertical = static_cast<i32>(radiusVertical);
+	const i64 horizontalSquared = i64{horizontal} * horizontal;
+	for (i32 x = -horizontal; x <= horizontal; ++x) {
+		for (i32 z = -horizontal; z <= horizontal; ++z) {
+			if (i64{x} * x + i64{z} * z > horizontalSquared) continue;
+			for (i32 y = -vertical; y <= vertical; ++y) offsets.push_back({x, y, z});
+		}
+	}
+
+	// Stable so that the order is the same on every run
+	std::stable_sort(offsets.begin(), offsets.end(), [](const Offset& a, const Offset& b) {
+		return a.x * a.x + a.y * a.y + a.z * a.z < b.x * b.x + b.y * b.y + b.z * b.z;
+	});
+	loadedBits.resize((offsets.size() + 63) / 64);
+}
+
+
+
+void ChunkLoadOrder::markLoaded(size_t index) {
+	assert(!isLoaded(index) && "Attempted to load a chunk twice");
+	loadedBits[index / 64] |= uint64_t{1} << (index % 64);
+	remaining--;
+}
+
+
+
+ChunkPos ChunkLoadOrder::getPosition(size_t index) const {
+	const Offset& offset = offsets[index];
+	return ChunkPos(centre.getX() + offset.x, centre.getY() + offset.y, centre.getZ() + offset.z);
+}
+
+
+
+size_t ChunkLoadOrder::countWithin(i32 radius) const {
+	const i64 radiusSquared = i64{radius} * radius;
+	auto end = std::partition_point(offsets.begin(), offsets.end(), [&](const Offset& offset) {
+		return i64{offset.x} * offset.x + i64{offset.y} * offset.y + i64{offset.z} * offset.z <= radiusSquared;
+	});
+	return static_cast<size_t>(end - offsets.begin());
+}
+
+
+
+size_t ChunkLoadOrder::getRemaining() const { return remaining; }
+std::chrono::steady_clock::time_point ChunkLoadOrder::getTimeRecentred() const { return timeRecentred; }
@@ -0,0 +1,79 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "ChunkPos.h"
+
+
+
+/*
+Every chunk offset within the load area (a cylinder around the load centre), sorted by distance from the centre.
+Loading walks the table in order, with a bitmap recording which entries already exist, so finding the next chunk to
+load is a short linear scan. Everything before the cursor is known to be loaded, so the scan never revisits the
+finished inner part of the area.
+*/
+class ChunkLoadOrder {
+private:
+	struct Offset {
+		i32 x;
+		i32 y;
+		i32 z;
+	};
+
+	std::vector<Offset> offsets;
+	std::vector<uint64_t> loadedBits;
+	size_t cursor = 0;
+	size_t remaining = 0;
+
+	ChunkPos centre;
+	std::chrono::steady_clock::time_point timeRecentred;
+
+private:
+	bool isLoaded(size_t index) const { return loadedBits[index / 64] >> (index % 64) & 1; }
+
+public:
+	ChunkLoadOrder(uint32_t radiusHorizontal, uint32_t radiusVertical);
+
+	ChunkLoadOrder(ChunkLoadOrder&&) = delete;
+	ChunkLoadOrder(const ChunkLoadOrder&) = delete;
+	ChunkLoadOrder operator=(ChunkLoadOrder&&) = delete;
+	ChunkLoadOrder operator=(const ChunkLoadOrder&) = delete;
+
+	// Moves the table to a new centre, chunkExists decides which of the entries around it are already loaded
+	template <typename Predicate>
+	void recentre(ChunkPos newCentre, Predicate chunkExists) {
+		centre = newCentre;
+		timeRecentred = std::chrono::steady_clock::now();
+		cursor = 0;
+		remaining = 0;
+		for (size_t i = 0; i < offsets.size(); ++i) {
+			bool loaded = chunkExists(getPosition(i));
+			if (loaded) loadedBits[i / 64] |= uint64_t{1} << (i % 64);
+			else {
+				loadedBits[i / 64] &= ~(uint64_t{1} << (i % 64));
+				remaining++;
+			}
+		}
+	}
+
+	// Calls visit with the index of each of the next maxCount unloaded entries, in order of distance
+	template <typename Visitor>
+	void forEachPending(size_t maxCount, Visitor visit) {
+		while (cursor < offsets.size() && isLoaded(cursor)) cursor++;
+		for (size_t i = cursor; i < offsets.size() && maxCount; ++i) {
+			if (isLoaded(i)) continue;
+			visit(i);
+			maxCount--;
+		}
+	}
+
+	void markLoaded(size_t index);
+
+	ChunkPos getPosition(size_t index) const;
+	// Number of entries in the table at most radius chunks from the centre, which are the entries at the start
+	size_t countWithin(i32 radius) const;
+	size_t getRemaining() const;
+	// When the current centre was set, which is when the pending chunks were last requested
+	std::chrono::steady_clock::time_point getTimeRecentred() const;
+};
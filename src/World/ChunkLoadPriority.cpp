@@ -0,0 +1,65 @@
+#include "ChunkLoadPriority.h"
+#include <algorithm>
+#include <cmath>
+
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+
+#include "Generation/HeightMap.h"
+
+
+
+// Chunks directly behind the player are treated as this much further away again
+constexpr double VIEW_WEIGHT = 1.5;
+// The view direction is ignored this close to the player, so the chunks around them always load first
+constexpr double VIEW_NEAR_DISTANCE = 2.0;
+// How far ahead the player's movement is extrapolated, in seconds and at most in chunks
+constexpr double VELOCITY_LOOKAHEAD = 1.5;
+constexpr double VELOCITY_LOOKAHEAD_MAX = 8.0;
+// Extra distance per chunk of vertical separation from the surface
+constexpr double SURFACE_WEIGHT = 0.5;
+
+
+
+ChunkPriorityView ChunkPriorityView::fromEntity(const EntityPosition& entityPosition, double tickSeconds) {
+	double rotationX = glm::radians(entityPosition.xRotation);
+	double rotationY = glm::radians(std::clamp(entityPosition.yRotation, -89.9, 89.9));
+	return ChunkPriorityView{
+		.position = entityPosition.pos,
+		.forward = glm::dvec3(
+			std::cos(rotationX) * std::cos(rotationY),
+			std::sin(rotationY),
+			std::sin(rotationX) * std::cos(rotationY)
+		),
+		.velocity = entityPosition.displacement / tickSeconds
+	};
+}
+
+
+
+double chunkLoadPriority(ChunkPos pos, const ChunkPriorityView& view, const HeightMap* heightMap) {
+	const glm::dvec3 chunkCentre = (glm::dvec3(pos.getX(), pos.getY(), pos.getZ()) + 0.5) * CHUNK_SIZE_D;
+	const glm::dvec3 offset = (chunkCentre - view.position) / CHUNK_SIZE_D;
+	double distance = glm::length(offset);
+
+	// Rank chunks around where the player is about to be as highly as those around where they are now
+	glm::dvec3 lookahead = view.velocity * (VELOCITY_LOOKAHEAD / CHUNK_SIZE_D);
+	double lookaheadLength = glm::length(lookahead);
+	if (lookaheadLength > VELOCITY_LOOKAHEAD_MAX) lookahead *= VELOCITY_LOOKAHEAD_MAX / lookaheadLength;
+	double effectiveDistance = std::min(distance, glm::length(offset - lookahead));
+
+	if (distance > 0.0) {
+		double alignment = glm::dot(offset / distance, view.forward);
+		double nearness = std::min(distance / VIEW_NEAR_DISTANCE, 1.0);
+		effectiveDistance *= 1.0 + VIEW_WEIGHT * 0.5 * (1.0 - alignment) * nearness;
+	}
+
+	if (heightMap) {
+		const double chunkBottom = pos.getY() * CHUNK_SIZE_D;
+		const double chunkTop = chunkBottom + CHUNK_SIZE_D;
+		double surfaceGap = std::max({0.0, heightMap->heightMin - chunkTop, chunkBottom - heightMap->heightMax});
+		effectiveDistance += SURFACE_WEIGHT * surfaceGap / CHUNK_SIZE_D;
+	}
+
+	return -effectiveDistance;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <glm/vec3.hpp>
+
+#include "ChunkPos.h"
+#include "Entities/EntityPosition.h"
+class HeightMap;
+
+
+
+// The parts of the player's state that chunk priorities depend on, captured once per tick
+struct ChunkPriorityView {
+	// Player position in blocks
+	glm::dvec3 position{0.0};
+	// Unit vector in the direction the camera is facing, zero when unknown
+	glm::dvec3 forward{0.0};
+	// Blocks per second
+	glm::dvec3 velocity{0.0};
+
+	static ChunkPriorityView fromEntity(const EntityPosition& entityPosition, double tickSeconds);
+};
+
+
+
+/*
+Higher values are more urgent. The priority is the negated distance from the player to the chunk in chunks, which is
+stretched for chunks outside the view direction or far from the terrain surface, and shortened for chunks around
+where the player is heading. The surface term is skipped if the column's height map hasn't been generated yet.
+*/
+double chunkLoadPriority(ChunkPos pos, const ChunkPriorityView& view, const HeightMap* heightMap);
@@ -0,0 +1,54 @@
+#include "ChunkNeighbourhood.h"
+#include <memory>
+#include <variant>
+
+
+
+ChunkNeighbourhood::ChunkNeighbourhood(ChunkPos _centre, const std::array<const Chunk*, 27>& _chunks) :
+	centre{_centre}
+{
+	for (i32 dx = -1; dx <= 1; ++dx) {
+	for (i32 dy = -1; dy <= 1; ++dy) {
+	for (i32 dz = -1; dz <= 1; ++dz) {
+		setChunk(dx, dy, dz, _chunks[getOffsetIndex(dx, dy, dz)]);
+	}
+	}
+	}
+}
+
+
+
+ChunkNeighbourhood::ChunkNeighbourhood(const Chunk* chunkCentre, const std::array<Chunk*, 6>& neighbours) :
+	centre{chunkCentre->getPosition()}
+{
+	constexpr i32 DIRECTION_OFFSETS[6][3] = {
+		{ 0,  1,  0},
+		{ 0, -1,  0},
+		{ 1,  0,  0},
+		{-1,  0,  0},
+		{ 0,  0,  1},
+		{ 0,  0, -1}
+	};
+	setChunk(0, 0, 0, chunkCentre);
+	for (size_t i = 0; i < neighbours.size(); ++i) {
+		const auto [_dx, _dy, _dz] = DIRECTION_OFFSETS[i];
+		setChunk(_dx, _dy, _dz, neighbours[i]);
+	}
+}
+
+
+
+void ChunkNeighbourhood::setChunk(i32 dx, i32 dy, i32 dz, const Chunk* chunk) {
+	ChunkView& _view = chunks[getOffsetIndex(dx, dy, dz)];
+	_view = ChunkView{};
+	if (!chunk) return;
+
+	const BlockContainer& _blocks = chunk->blockContainer;
+	_view.present = true;
+	_view.palette = _blocks.blockArrayBlocksByIndex.data();
+	if (auto _bytes = std::get_if<std::shared_ptr<uint8_t[]>>(&_blocks.blockArray)) _view.indicesByte = _bytes->get();
+	else if (auto _shorts = std::get_if<std::shared_ptr<uint16_t[]>>(&_blocks.blockArray)) {
+		_view.indicesShort = _shorts->get();
+	}
+	else _view.singleBlock = std::get<Block>(_blocks.blockArray);
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+
+#include "Core/RevetteCore.h"
+#include "Block.h"
+#include "Chunk.h"
+#include "ChunkPos.h"
+
+
+
+/*
+A chunk and the chunks around it, for reading blocks near the chunk without looking up their chunk in the world for
+every block. The block storage of each chunk is resolved once when the neighbourhood is built, so reading a block is
+an index calculation and an array load, plus a palette lookup. Positions are relative to the centre chunk's origin and
+range from -CHUNK_SIZE to 2 * CHUNK_SIZE - 1 on each axis. The neighbourhood is only valid until one of its chunks is
+changed, as that can replace the chunk's block storage.
+*/
+class ChunkNeighbourhood {
+private:
+	// Block storage of one chunk, only one of the arrays is set unless the chunk is a single block
+	struct ChunkView {
+		const u8* indicesByte = nullptr;
+		const u16* indicesShort = nullptr;
+		const Block* palette = nullptr;
+		Block singleBlock{Block(0)};
+		bool present = false;
+	};
+
+	std::array<ChunkView, 27> chunks;
+	ChunkPos centre;
+
+	void setChunk(i32 dx, i32 dy, i32 dz, const Chunk* chunk);
+
+	static size_t getChunkIndex(i32 x, i32 y, i32 z) {
+		// The arithmetic shift maps each axis to -1, 0 or 1
+		return static_cast<size_t>(
+			((x >> CHUNK_SIZE_LOG) + 1) * 9 + ((y >> CHUNK_SIZE_LOG) + 1) * 3 + ((z >> CHUNK_SIZE_LOG) + 1)
+		);
+	}
+
+public:
+	// Takes the chunk at each offset from the centre, CHUNK_NEIGHBOUR_OFFSETS plus the centre itself, where missing
+	// chunks are null
+	ChunkNeighbourhood(ChunkPos _centre, const std::array<const Chunk*, 27>& _chunks);
+	// Only the centre and the chunks sharing a face with it, in AxisDirection order
+	ChunkNeighbourhood(const Chunk* chunkCentre, const std::array<Chunk*, 6>& neighbours);
+
+	ChunkPos getCentre() const { return centre; }
+
+	// Index into the array passed to the constructor of the chunk at an offset
+	static size_t getOffsetIndex(i32 dx, i32 dy, i32 dz) {
+		return static_cast<size_t>((dx + 1) * 9 + (dy + 1) * 3 + (dz + 1));
+	}
+
+	static bool inRange(i32 x, i32 y, i32 z) {
+		return (
+			x >= -CHUNK_SIZE && x < 2 * CHUNK_SIZE &&
+			y >= -CHUNK_SIZE && y < 2 * CHUNK_SIZE &&
+			z >= -CHUNK_SIZE && z < 2 * CHUNK_SIZE
+		);
+	}
+
+	// Whether the chunk holding the position was given, the position must be in range
+	bool hasChunk(i32 x, i32 y, i32 z) const {
+		return chunks[getChunkIndex(x, y, z)].present;
+	}
+
+	// Blocks in missing chunks read as air, the position must be in range
+	Block getBlock(i32 x, i32 y, i32 z) const {
+		const ChunkView& _chunk = chunks[getChunkIndex(x, y, z)];
+		const auto _index = static_cast<size_t>(
+			((x & (CHUNK_SIZE - 1)) << (2 * CHUNK_SIZE_LOG)) |
+			((y & (CHUNK_SIZE - 1)) << CHUNK_SIZE_LOG) |
+			(z & (CHUNK_SIZE - 1))
+		);
+		if (_chunk.indicesByte) return _chunk.palette[_chunk.indicesByte[_index]];
+		if (_chunk.indicesShort) return _chunk.palette[_chunk.indicesShort[_index]];
+		return _chunk.singleBlock;
+	}
+};
@@ -0,0 +1,61 @@
+#include "ChunkPipelineScheduler.h"
+#include <algorithm>
+
+
+
+// Weight of the most recent item in the moving average of item costs
+constexpr double ITEM_COST_SMOOTHING = 0.1;
+// Rough costs for the first items, before any have been measured
+constexpr std::array<double, ChunkPipelineScheduler::STAGE_COUNT> INITIAL_ITEM_COST = {400.0, 300.0, 500.0};
+
+// The budget takes a fraction of the spare time each tick, and backs off quickly once ticks overrun
+constexpr double BUDGET_GROWTH_RATE = 0.25;
+constexpr double BUDGET_BACKOFF_RATE = 0.7;
+
+
+
+ChunkPipelineScheduler::ChunkPipelineScheduler(
+	std::chrono::microseconds _budgetMin,
+	std::chrono::microseconds _budgetMax,
+	std::chrono::microseconds _tickReserve
+) :
+	budgetMin{_budgetMin},
+	budgetMax{std::max(_budgetMin, _budgetMax)},
+	tickReserve{_tickReserve},
+	budget{static_cast<double>(_budgetMin.count())},
+	itemCost{INITIAL_ITEM_COST}
+{}
+
+
+
+std::chrono::microseconds ChunkPipelineScheduler::beginTick(Clock::time_point tickDeadline) {
+	tickBegin = Clock::now();
+	auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(tickDeadline - tickBegin) - tickReserve;
+	tickBudget = std::chrono::microseconds(static_cast<long long>(budget));
+	// Even when the tick is already late the minimum is kept, so that chunks keep streaming in on slow machines
+	tickBudget = std::max(std::min(tickBudget, remaining), budgetMin);
+	return tickBudget;
+}
+
+
+
+bool ChunkPipelineScheduler::canAfford(Stage stage) const {
+	auto elapsed = std::chrono::duration<double, std::micro>(Clock::now() - tickBegin).count();
+	return elapsed + itemCost[static_cast<size_t>(stage)] <= static_cast<double>(tickBudget.count());
+}
+
+
+
+void ChunkPipelineScheduler::recordItem(Stage stage, std::chrono::microseconds duration) {
+	double& cost = itemCost[static_cast<size_t>(stage)];
+	cost += (static_cast<double>(duration.count()) - cost) * ITEM_COST_SMOOTHING;
+}
+
+
+
+void ChunkPipelineScheduler::endTick(std::chrono::microseconds tickDuration, std::chrono::microseconds tickInterval) {
+	auto slack = static_cast<double>((tickInterval - tickReserve - tickDuration).count());
+	if (slack > 0.0) budget += slack * BUDGET_GROWTH_RATE;
+	else budget *= BUDGET_BACKOFF_RATE;
+	budget = std::clamp(budget, static_cast<double>(budgetMin.count()), static_cast<double>(budgetMax.count()));
+}
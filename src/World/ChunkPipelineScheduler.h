@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+
+
+/*
+Decides how much chunk loading, population and meshing work fits into each tick. The cost of an item in each stage
+is measured as it runs and smoothed with an exponentially weighted moving average, and work stops once the next
+item is expected to overrun the budget. The budget itself grows while ticks finish with time to spare and shrinks
+quickly when they don't, so it settles near whatever the machine can sustain.
+*/
+class ChunkPipelineScheduler {
+public:
+	enum class Stage : size_t {
+		Load,
+		Populate,
+		Mesh,
+		COUNT
+	};
+	static constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::COUNT);
+
+	using Clock = std::chrono::steady_clock;
+
+private:
+	std::chrono::microseconds budgetMin;
+	std::chrono::microseconds budgetMax;
+	// Time left free at the end of every tick for everything besides the chunk pipeline
+	std::chrono::microseconds tickReserve;
+
+	double budget;
+	std::array<double, STAGE_COUNT> itemCost;
+
+	Clock::time_point tickBegin;
+	std::chrono::microseconds tickBudget{};
+
+public:
+	ChunkPipelineScheduler(
+		std::chrono::microseconds _budgetMin,
+		std::chrono::microseconds _budgetMax,
+		std::chrono::microseconds _tickReserve
+	);
+
+	// Returns the budget for this tick, which is cut short if the tick deadline is close
+	std::chrono::microseconds beginTick(Clock::time_point tickDeadline);
+	// Whether an item of the stage is expected to fit in what's left of this tick's budget
+	bool canAfford(Stage stage) const;
+	void recordItem(Stage stage, std::chrono::microseconds duration);
+	// Adapts the budget to how long the whole tick took
+	void endTick(std::chrono::microseconds tickDuration, std::chrono::microseconds tickInterval);
+};
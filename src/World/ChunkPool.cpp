@@ -0,0 +1,57 @@
+#include "ChunkPool.h"
+
+#include "../Profiling/Trace.h"
+
+
+
+ChunkPool::ChunkPool(size_t _capacity) : capacity{_capacity} {
+	freeChunks.reserve(capacity);
+}
+
+
+
+std::unique_ptr<Chunk> ChunkPool::acquire(ChunkPos pos) {
+	if (freeChunks.empty()) return std::make_unique<Chunk>(pos);
+
+	std::unique_ptr<Chunk> chunk = std::move(freeChunks.back());
+	freeChunks.pop_back();
+	chunk->reset(pos);
+	return chunk;
+}
+
+
+
+void ChunkPool::release(std::unique_ptr<Chunk> chunk) {
+	releasedChunks.push_back(std::move(chunk));
+}
+
+
+
+void ChunkPool::releaseAll(std::vector<std::unique_ptr<Chunk>> chunks) {
+	for (auto& chunk : releasedChunks) chunks.push_back(std::move(chunk));
+	releasedChunks.clear();
+	// Assigning joins the previous thread, which only blocks if the last bulk release hasn't finished yet
+	destructionThread = std::jthread([destroyChunks = std::move(chunks)]() mutable {
+		TRACE_THREAD_NAME("Chunk destruction");
+		TRACE_ZONE("ChunkPool::releaseAll");
+		destroyChunks.clear();
+	});
+}
+
+
+
+void ChunkPool::processReleased(size_t maxCount) {
+	TRACE_ZONE("ChunkPool::processReleased");
+	for (; maxCount && !releasedChunks.empty(); --maxCount) {
+		std::unique_ptr<Chunk> chunk = std::move(releasedChunks.front());
+		releasedChunks.pop_front();
+		if (freeChunks.size() < capacity) {
+			chunk->reset(chunk->getPosition());
+			freeChunks.push_back(std::move(chunk));
+		}
+	}
+}
+
+
+
+size_t ChunkPool::getReleasedCount() const { return releasedChunks.size(); }
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Chunk.h"
+
+
+
+/*
+Unloaded chunks are handed to the pool instead of being destroyed on the spot. Their block storage is freed a few
+at a time each tick, so unloading a large area doesn't stall a single tick, and the emptied chunk objects are kept
+for reuse by later loads.
+*/
+class ChunkPool {
+private:
+	size_t capacity;
+	std::vector<std::unique_ptr<Chunk>> freeChunks;
+	std::deque<std::unique_ptr<Chunk>> releasedChunks;
+	// Destroys chunks released in bulk
+	std::jthread destructionThread;
+
+public:
+	ChunkPool(size_t _capacity);
+
+	ChunkPool(ChunkPool&&) = delete;
+	ChunkPool(const ChunkPool&) = delete;
+	ChunkPool operator=(ChunkPool&&) = delete;
+	ChunkPool operator=(const ChunkPool&) = delete;
+
+	std::unique_ptr<Chunk> acquire(ChunkPos pos);
+	void release(std::unique_ptr<Chunk> chunk);
+	// Destroys the chunks, along with any released ones still waiting, on a background thread
+	void releaseAll(std::vector<std::unique_ptr<Chunk>> chunks);
+	// Empties up to maxCount released chunks, keeping them for reuse while the pool has room
+	void processReleased(size_t maxCount);
+
+	size_t getReleasedCount() const;
+};
@@ -45,6 +45,15 @@ StatusChunkMesh ChunkStatusMap::getChunkStatusMesh(const ChunkPos chunkPos) cons
 
 
 
+std::chrono::steady_clock::time_point ChunkStatusMap::getChunkTimeRequested(const ChunkPos chunkPos) const
+{
+	auto chunkStatusIterator = statusMap.find(chunkPos);
+	if (chunkStatusIterator == statusMap.end()) return {};
+	else return chunkStatusIterator->second.getTimeRequested();
+}
+
+
+
 void ChunkStatusMap::setChunkStatusLoad(const ChunkPos chunkPos, StatusChunkLoad status)
 {
 	if (status == StatusChunkLoad::NON_EXISTENT) statusMap.erase(chunkPos);
@@ -54,6 +63,7 @@ void ChunkStatusMap::setChunkStatusLoad(const ChunkPos chunkPos, StatusChunkLoad
 		statusMap[chunkPos].setLoadStatus(status);
 		if (isNew)
 		{
+			statusMap[chunkPos].setTimeRequested(std::chrono::steady_clock::now());
 			// Get neighbour statuses
 			for (int i = -1; i <= 1; ++i)
 				for (int j = -1; j <= 1; ++j)
@@ -84,4 +94,11 @@ void ChunkStatusMap::setChunkStatusLoad(const ChunkPos chunkPos, StatusChunkLoad
 void ChunkStatusMap::setChunkStatusMesh(const ChunkPos chunkPos, StatusChunkMesh status)
 {
 	statusMap.at(chunkPos).setHasMesh(status);
+}
+
+
+
+void ChunkStatusMap::setChunkTimeRequested(const ChunkPos chunkPos, std::chrono::steady_clock::time_point time)
+{
+	statusMap.at(chunkPos).setTimeRequested(time);
 }
\ No newline at end of file
@@ -14,8 +14,10 @@ public:
 	bool getChunkStatusCanPopulate(const ChunkPos chunkPos) const;
 	StatusChunkLoad getChunkStatusLoad(const ChunkPos chunkPos) const;
 	StatusChunkMesh getChunkStatusMesh(const ChunkPos chunkPos) const;
+	std::chrono::steady_clock::time_point getChunkTimeRequested(const ChunkPos chunkPos) const;
 	void setChunkStatusLoad(const ChunkPos chunkPos, StatusChunkLoad status);
 	void setChunkStatusMesh(const ChunkPos chunkPos, StatusChunkMesh status);
+	void setChunkTimeRequested(const ChunkPos chunkPos, std::chrono::steady_clock::time_point time);
 
 	std::unordered_map<ChunkPos, StatusChunk> statusMap;
 };
\ No newline at end of file
@@ -111,6 +111,20 @@ void EntityPosition::rotate(const double xRot, const double yRot)
 
 
 
+EntityPosition EntityPosition::interpolate(const EntityPosition& from, const EntityPosition& to, const double t)
+{
+	glm::dvec3 offset = to.pos - from.pos;
+	offset.x = wrapCoordinate(offset.x);
+	offset.z = wrapCoordinate(offset.z);
+
+	double xRotationOffset = fmod(to.xRotation - from.xRotation + 540.0, 360.0) - 180.0;
+	EntityPosition result(from.pos + offset * t, from.xRotation, from.yRotation + (to.yRotation - from.yRotation) * t);
+	result.rotate(xRotationOffset * t, 0.0);
+	return result;
+}
+
+
+
 void EntityPosition::wrapCoordinates()
 {
 	pos.x = wrapCoordinate(pos.x);
@@ -19,6 +19,9 @@ public:
 	void displaceVertical(const double distance);
 	void rotate(const double xRot, const double yRot);
 
+	// Blends between two positions, taking the short way around both the world and the horizontal rotation
+	static EntityPosition interpolate(const EntityPosition& from, const EntityPosition& to, const double t);
+
 	glm::dvec3 pos;
 	glm::dvec3 displacement;
 	double xRotation;
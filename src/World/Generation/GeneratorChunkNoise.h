@@ -5,6 +5,14 @@ class GeneratorChunkParameters;
 
 
 
+// Generation settings of the world, shared by the game and the pregenerator so that both produce the same terrain
+constexpr int WORLD_SEED = 24383737;
+constexpr const char* NOISE_HEIGHTMAP = "FQkXCRUJDQAH@BCGZmBkAJBg@AIBEBAOamRk/C83MTD0EAg8JBg@AIBFBAOamRk/DAMAAKBBBAMAAEBBBA==";
+constexpr const char* NOISE_TEMPERATURE = "KQkNCQY@CRRQ=";
+constexpr const char* NOISE_RAINFALL = "KQkNCQY@CRRQ=";
+
+
+
 // A config object that stores all the required noise generators for chunk generation
 class GeneratorChunkNoise
 {
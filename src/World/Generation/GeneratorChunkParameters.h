@@ -15,6 +15,10 @@ public:
 	{}
 	GeneratorChunkParameters(const GeneratorChunkParameters&) = delete;
 
+	const HeightMap& getHeightMap() const { return heightMap; }
+	// Makes the whole column one biome, for benchmarking the population of a single biome
+	void overrideBiome(BIOME biome) { biomeMap.biomeArray.fill(biome); }
+
 private:
 	HeightMap heightMap;
 	BiomeMap biomeMap;
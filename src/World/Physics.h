@@ -1,38 +0,0 @@
-#pragma once
-
-
-
-namespace Physics
-{
-
-	// This should like absolutely not be a compile time declared array, and quite frankly needs better formatting.
-	// However I leave the responsibility of figuring all that out to some point in the future.
-	const bool IS_COLLIDABLE[] = {
-			false,
-			true,
-			true,
-			true,
-			true,
-			true,
-			false,
-			true,
-			true,
-			true,
-			false,
-			true,
-			false,
-			true,
-			false,
-			true,
-			true,
-			true,
-			true,
-			true,
-			true,
-			true,
-			true,
-			true,
-			true,
-			true
-	};
-}
\ No newline at end of file
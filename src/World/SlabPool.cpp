@@ -0,0 +1,179 @@
+#include "SlabPool.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <new>
+#include <stdexcept>
+
+#include <sys/mman.h>
+
+
+
+namespace {
+
+constexpr size_t MAX_POOLS = 8;
+constexpr size_t PAGE_SIZE = 4096;
+constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+// Upper bound on the memory each thread keeps in its cache of a pool, though every cache holds at least a few slots
+constexpr size_t THREAD_CACHE_BYTES = 256 * 1024;
+constexpr size_t THREAD_CACHE_MIN_SLOTS = 4;
+
+std::atomic<size_t> configuredSlabSize{HUGE_PAGE_SIZE};
+std::atomic_bool configuredHugePages{false};
+
+// Pools are statics which live until the end of the program, after every thread's cache has been returned
+std::mutex registryMutex;
+std::array<SlabPool*, MAX_POOLS> registry{};
+size_t registrySize = 0;
+
+
+
+size_t roundUp(size_t size, size_t alignment) {
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+
+
+// Slots held by this thread, which are returned to their pools when it exits
+struct ThreadCache {
+	std::array<std::vector<void*>, MAX_POOLS> slots;
+
+	~ThreadCache() {
+		for (size_t i = 0; i < MAX_POOLS; ++i) {
+			if (!slots[i].empty()) registry[i]->returnSlots(slots[i], slots[i].size());
+		}
+	}
+};
+
+thread_local ThreadCache threadCache;
+
+}
+
+
+
+SlabPool::SlabPool(const char* _name, size_t _slotSize) :
+	name{_name},
+	slotSize{roundUp(_slotSize, alignof(std::max_align_t))},
+	cacheCapacity{std::max(THREAD_CACHE_BYTES / slotSize, THREAD_CACHE_MIN_SLOTS)}
+{
+	std::scoped_lock lock(registryMutex);
+	if (registrySize == MAX_POOLS) throw std::runtime_error("Too many slab pools");
+	index = registrySize++;
+	registry[index] = this;
+}
+
+
+
+SlabPool::~SlabPool() {
+	for (auto [_slab, _size] : slabs) munmap(_slab, _size);
+}
+
+
+
+// Huge pages are only used when some have been reserved for the system, otherwise the kernel is asked to back the
+// slab with transparent huge pages where it can
+void SlabPool::allocateSlab() {
+	const bool _hugePages = configuredHugePages.load(std::memory_order_relaxed);
+	const size_t _slabSize = roundUp(
+		std::max(configuredSlabSize.load(std::memory_order_relaxed), slotSize),
+		_hugePages ? HUGE_PAGE_SIZE : PAGE_SIZE
+	);
+
+	void* _slab = MAP_FAILED;
+#ifdef MAP_HUGETLB
+	if (_hugePages) {
+		_slab = mmap(nullptr, _slabSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (_slab != MAP_FAILED) slabsOnHugePages++;
+	}
+#endif
+	if (_slab == MAP_FAILED) {
+		_slab = mmap(nullptr, _slabSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (_slab == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+		if (_hugePages) madvise(_slab, _slabSize, MADV_HUGEPAGE);
+#endif
+	}
+	slabs.push_back({ _slab, _slabSize });
+
+	auto* _bytes = static_cast<std::byte*>(_slab);
+	for (size_t _offset = 0; _offset + slotSize <= _slabSize; _offset += slotSize) {
+		freeSlots.push_back(_bytes + _offset);
+	}
+}
+
+
+
+void* SlabPool::allocate() {
+	auto& _cache = threadCache.slots[index];
+	if (_cache.empty()) takeSlots(_cache, cacheCapacity / 2 + 1);
+	void* _slot = _cache.back();
+	_cache.pop_back();
+
+	const size_t _inUse = slotsInUse.fetch_add(1, std::memory_order_relaxed) + 1;
+	size_t _highWater = slotsHighWater.load(std::memory_order_relaxed);
+	while (_highWater < _inUse) {
+		if (slotsHighWater.compare_exchange_weak(_highWater, _inUse, std::memory_order_relaxed)) break;
+	}
+	return _slot;
+}
+
+
+
+void SlabPool::deallocate(void* slot) {
+	auto& _cache = threadCache.slots[index];
+	if (_cache.size() >= cacheCapacity) returnSlots(_cache, cacheCapacity / 2);
+	_cache.push_back(slot);
+	slotsInUse.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+
+void SlabPool::takeSlots(std::vector<void*>& cache, size_t count) {
+	std::scoped_lock lock(mutex);
+	if (freeSlots.empty()) allocateSlab();
+	count = std::min(count, freeSlots.size());
+	cache.insert(cache.end(), freeSlots.end() - static_cast<std::ptrdiff_t>(count), freeSlots.end());
+	freeSlots.resize(freeSlots.size() - count);
+}
+
+
+
+void SlabPool::returnSlots(std::vector<void*>& cache, size_t count) {
+	std::scoped_lock lock(mutex);
+	count = std::min(count, cache.size());
+	freeSlots.insert(freeSlots.end(), cache.end() - static_cast<std::ptrdiff_t>(count), cache.end());
+	cache.resize(cache.size() - count);
+}
+
+
+
+SlabPool::Stats SlabPool::getStats() const {
+	std::scoped_lock lock(mutex);
+	size_t _slotsReserved = 0;
+	for (auto [_slab, _size] : slabs) _slotsReserved += _size / slotSize;
+	return Stats{
+		.name = name,
+		.slotSize = slotSize,
+		.slotsInUse = slotsInUse.load(std::memory_order_relaxed),
+		.slotsHighWater = slotsHighWater.load(std::memory_order_relaxed),
+		.slotsReserved = _slotsReserved,
+		.slabCount = slabs.size(),
+		.slabsOnHugePages = slabsOnHugePages
+	};
+}
+
+
+
+void SlabPool::configure(size_t slabSize, bool hugePages) {
+	configuredSlabSize.store(slabSize, std::memory_order_relaxed);
+	configuredHugePages.store(hugePages, std::memory_order_relaxed);
+}
+
+
+
+std::vector<SlabPool::Stats> SlabPool::getAllStats() {
+	std::scoped_lock lock(registryMutex);
+	std::vector<Stats> stats;
+	for (size_t i = 0; i < registrySize; ++i) stats.push_back(registry[i]->getStats());
+	return stats;
+}
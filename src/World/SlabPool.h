@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+
+
+/*
+Fixed size slots carved out of large slabs, for the chunk objects and block arrays which are created and destroyed
+constantly as the player moves. Freed slots go back onto the pool's free list rather than to the system, and slabs are
+only returned when the pool is destroyed. Each thread keeps a few free slots of every pool, and only takes the pool's
+lock to move a batch of them to or from the shared free list, as chunks are often freed on a different thread from
+the one which created them.
+*/
+class SlabPool {
+public:
+	struct Stats {
+		const char* name;
+		size_t slotSize;
+		size_t slotsInUse;
+		size_t slotsHighWater;
+		size_t slotsReserved;
+		size_t slabCount;
+		size_t slabsOnHugePages;
+	};
+
+private:
+	const char* name;
+	size_t slotSize;
+	// Position of the pool in the registry, and of its slots in each thread's cache
+	size_t index;
+	size_t cacheCapacity;
+
+	mutable std::mutex mutex;
+	std::vector<void*> freeSlots;
+	// Address and size of each slab
+	std::vector<std::pair<void*, size_t>> slabs;
+	size_t slabsOnHugePages = 0;
+
+	std::atomic<size_t> slotsInUse{0};
+	std::atomic<size_t> slotsHighWater{0};
+
+	void allocateSlab();
+
+public:
+	SlabPool(const char* _name, size_t _slotSize);
+	~SlabPool();
+
+	SlabPool(SlabPool&&) = delete;
+	SlabPool(const SlabPool&) = delete;
+	SlabPool operator=(SlabPool&&) = delete;
+	SlabPool operator=(const SlabPool&) = delete;
+
+	void* allocate();
+	void deallocate(void* slot);
+
+	// Moves up to count free slots from the pool into the cache, or from the cache back into the pool
+	void takeSlots(std::vector<void*>& cache, size_t count);
+	void returnSlots(std::vector<void*>& cache, size_t count);
+
+	Stats getStats() const;
+
+	// Sets the size of the slabs allocated from now on, and whether to try to back them with huge pages
+	static void configure(size_t slabSize, bool hugePages);
+	static std::vector<Stats> getAllStats();
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <array>
+#include <chrono>
 
 
 
@@ -31,6 +32,8 @@ public:
 	void setLoadStatus(StatusChunkLoad _loadStatus) { loadStatus = _loadStatus; }
 	StatusChunkMesh getMeshStatus() const { return hasMesh; }
 	void setHasMesh(StatusChunkMesh _hasMesh) { hasMesh = _hasMesh; }
+	std::chrono::steady_clock::time_point getTimeRequested() const { return timeRequested; }
+	void setTimeRequested(std::chrono::steady_clock::time_point _timeRequested) { timeRequested = _timeRequested; }
 
 	void setNeighbourLoadStatus(int xOffset, int yOffset, int zOffset, StatusChunkLoad _loadStatus);
 	bool canMesh() const;
@@ -39,6 +42,8 @@ public:
 private:
 	StatusChunkLoad loadStatus{ StatusChunkLoad::NON_EXISTENT };
 	StatusChunkMesh hasMesh{ StatusChunkMesh::NON_EXISTENT };
+	// When the chunk was first added to the status map, used to measure the latency until its mesh is ready
+	std::chrono::steady_clock::time_point timeRequested;
 	std::array<StatusChunkLoad, 26> neighboursLoaded{};
 	std::array<int, 6> neighbourLoadCountCardinal{ 6 };
 	std::array<int, 6> neighbourLoadCountCubic{ 20 };
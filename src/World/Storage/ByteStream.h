@@ -0,0 +1,66 @@
+#pragma once
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "../../Core/RevetteCore.h"
+
+
+
+// Appends trivially copyable values to a byte buffer, in native byte order
+class ByteWriter {
+private:
+	std::vector<u8>& data;
+
+public:
+	ByteWriter(std::vector<u8>& _data) : data{_data} {}
+
+	template <typename T>
+	void write(const T& value) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		const auto offset = data.size();
+		data.resize(offset + sizeof(T));
+		std::memcpy(data.data() + offset, &value, sizeof(T));
+	}
+
+	template <typename T>
+	void writeArray(std::span<const T> values) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		const auto offset = data.size();
+		data.resize(offset + values.size_bytes());
+		std::memcpy(data.data() + offset, values.data(), values.size_bytes());
+	}
+};
+
+
+
+// Reads values written by ByteWriter, throwing if the data runs out
+class ByteReader {
+private:
+	std::span<const u8> data;
+
+public:
+	ByteReader(std::span<const u8> _data) : data{_data} {}
+
+	template <typename T>
+	T read() {
+		static_assert(std::is_trivially_copyable_v<T>);
+		if (data.size() < sizeof(T)) throw std::runtime_error("Unexpected end of stored data");
+		T value;
+		std::memcpy(&value, data.data(), sizeof(T));
+		data = data.subspan(sizeof(T));
+		return value;
+	}
+
+	template <typename T>
+	void readArray(std::span<T> values) {
+		static_assert(std::is_trivially_copyable_v<T>);
+		if (data.size() < values.size_bytes()) throw std::runtime_error("Unexpected end of stored data");
+		std::memcpy(values.data(), data.data(), values.size_bytes());
+		data = data.subspan(values.size_bytes());
+	}
+
+	bool empty() const { return data.empty(); }
+};
@@ -0,0 +1,196 @@
+#include "EditJournal.h"
+
+#include <cstdio>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+
+#include "ByteStream.h"
+#include "../../GlobalLog.h"
+#include "../../Profiling/Trace.h"
+
+
+
+namespace {
+
+constexpr u32 JOURNAL_MAGIC = 0x4A525652; // "RVRJ"
+constexpr u32 JOURNAL_VERSION = 1;
+constexpr u64 JOURNAL_HEADER_SIZE = 2 * sizeof(u32);
+
+enum class RecordType : u8 {
+	Edit,
+	Checkpoint
+};
+
+constexpr u64 EDIT_RECORD_SIZE = sizeof(RecordType) + 3 * sizeof(i32) + sizeof(u16) + sizeof(i32);
+// The file is rewritten when it is at least this large and under half of it is edits that are still live
+constexpr u64 REWRITE_MIN_SIZE = 1 << 16;
+
+
+
+void writeChunkPos(ByteWriter& writer, ChunkPos pos) {
+	writer.write(pos.getX());
+	writer.write(pos.getY());
+	writer.write(pos.getZ());
+}
+
+ChunkPos readChunkPos(ByteReader& reader) {
+	const auto x = reader.read<i32>();
+	const auto y = reader.read<i32>();
+	const auto z = reader.read<i32>();
+	return ChunkPos(x, y, z);
+}
+
+}
+
+
+
+EditJournal::EditJournal(std::string _path) : path{std::move(_path)} {
+	replay();
+	file.open(path, std::ios::binary | std::ios::app);
+	if (!file.is_open()) throw std::runtime_error("Failed to open edit journal " + path);
+}
+
+
+
+EditJournal::~EditJournal() {
+	try {
+		flush();
+	}
+	catch (const std::exception& e) {
+		LOG_ERROR(std::string("Failed to save edits: ") + e.what());
+	}
+}
+
+
+
+// A record cut short by a crash is dropped, and the file is rewritten so that new records don't follow it
+void EditJournal::replay() {
+	std::ifstream input(path, std::ios::binary);
+	if (!input.is_open()) {
+		rewrite();
+		return;
+	}
+	std::vector<u8> data{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+	input.close();
+
+	ByteReader reader{std::span<const u8>(data)};
+	if (
+		data.size() < JOURNAL_HEADER_SIZE ||
+		reader.read<u32>() != JOURNAL_MAGIC ||
+		reader.read<u32>() != JOURNAL_VERSION
+	) {
+		throw std::runtime_error("Invalid edit journal " + path);
+	}
+
+	try {
+		while (!reader.empty()) {
+			const auto type = reader.read<RecordType>();
+			const ChunkPos chunkPos = readChunkPos(reader);
+			if (type == RecordType::Edit) {
+				const auto index = reader.read<u16>();
+				const auto block = reader.read<i32>();
+				if (index >= CHUNK_VOLUME) throw std::runtime_error("Edit journal block index out of range");
+				edits[chunkPos][index] = Block(block);
+			}
+			else if (type == RecordType::Checkpoint) edits.erase(chunkPos);
+			else throw std::runtime_error("Unknown edit journal record");
+		}
+		fileSize = data.size();
+	}
+	catch (const std::runtime_error& e) {
+		LOG_WARNING(std::string("Edit journal is truncated, dropping the last record: ") + e.what());
+		fileSize = 0;
+	}
+
+	editCount = 0;
+	for (const auto& [_pos, chunkEdits] : edits) editCount += chunkEdits.size();
+	if (!fileSize) rewrite();
+}
+
+
+
+// Writes only the live edits to a new file, which replaces the old one once it is complete
+void EditJournal::rewrite() {
+	TRACE_ZONE("EditJournal::rewrite");
+	std::vector<u8> data;
+	data.reserve(JOURNAL_HEADER_SIZE + editCount * EDIT_RECORD_SIZE);
+	ByteWriter writer(data);
+	writer.write(JOURNAL_MAGIC);
+	writer.write(JOURNAL_VERSION);
+	for (const auto& [_chunkPos, chunkEdits] : edits) {
+		for (const auto& [_index, _block] : chunkEdits) {
+			writer.write(RecordType::Edit);
+			writeChunkPos(writer, _chunkPos);
+			writer.write(_index);
+			writer.write(static_cast<i32>(_block.blockType));
+		}
+	}
+
+	std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!output.is_open()) throw std::runtime_error("Failed to open edit journal for writing");
+		output.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+		if (!output) throw std::runtime_error("Failed to write edit journal");
+	}
+
+	bool reopen = file.is_open();
+	if (reopen) file.close();
+	if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+		throw std::runtime_error("Failed to rename edit journal");
+	}
+	if (reopen) file.open(path, std::ios::binary | std::ios::app);
+	fileSize = data.size();
+}
+
+
+
+void EditJournal::recordEdit(ChunkPos chunkPos, ChunkLocalBlockPos blockPos, Block block) {
+	auto [_edit, inserted] = edits[chunkPos].insert_or_assign(blockPos.asIndex(), block);
+	if (inserted) editCount++;
+
+	ByteWriter writer(pendingRecords);
+	writer.write(RecordType::Edit);
+	writeChunkPos(writer, chunkPos);
+	writer.write(blockPos.asIndex());
+	writer.write(static_cast<i32>(block.blockType));
+}
+
+
+
+void EditJournal::recordCheckpoint(ChunkPos chunkPos) {
+	auto chunkEdits = edits.find(chunkPos);
+	if (chunkEdits == edits.end()) return;
+	editCount -= chunkEdits->second.size();
+	edits.erase(chunkEdits);
+
+	ByteWriter writer(pendingRecords);
+	writer.write(RecordType::Checkpoint);
+	writeChunkPos(writer, chunkPos);
+}
+
+
+
+void EditJournal::flush() {
+	if (pendingRecords.empty()) return;
+	TRACE_ZONE("EditJournal::flush");
+	file.write(reinterpret_cast<const char*>(pendingRecords.data()), static_cast<std::streamsize>(pendingRecords.size()));
+	file.flush();
+	if (!file) throw std::runtime_error("Failed to write edit journal");
+	fileSize += pendingRecords.size();
+	pendingRecords.clear();
+
+	if (fileSize >= REWRITE_MIN_SIZE && (JOURNAL_HEADER_SIZE + editCount * EDIT_RECORD_SIZE) * 2 < fileSize) rewrite();
+}
+
+
+
+const EditJournal::ChunkEdits* EditJournal::getEdits(ChunkPos chunkPos) const {
+	auto chunkEdits = edits.find(chunkPos);
+	return chunkEdits != edits.end() ? &chunkEdits->second : nullptr;
+}
+
+
+
+const std::unordered_map<ChunkPos, EditJournal::ChunkEdits>& EditJournal::getAllEdits() const { return edits; }
@@ -0,0 +1,55 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../Block.h"
+#include "../ChunkPos.h"
+
+
+
+/*
+Block edits are saved as changes on top of the generated terrain rather than as whole chunks, so that the save grows
+with the number of edits instead of the area explored. Every edit is appended to the journal file, and replaying the
+file rebuilds the latest block for every edited position. Once a chunk has enough edits it is checkpointed by writing
+the whole chunk to its region file, after which a record is appended to drop its edits from the journal. Replaying
+edits is idempotent, so a crash between the two writes only means that some edits are applied twice.
+*/
+class EditJournal {
+public:
+	// Latest block for each edited position in a chunk, by index in the chunk
+	using ChunkEdits = std::unordered_map<u16, Block>;
+
+private:
+	std::string path;
+	std::ofstream file;
+	std::unordered_map<ChunkPos, ChunkEdits> edits;
+	// Records not yet written to the file
+	std::vector<u8> pendingRecords;
+	u64 fileSize = 0;
+	u64 editCount = 0;
+
+private:
+	void replay();
+	void rewrite();
+
+public:
+	EditJournal(std::string _path);
+	~EditJournal();
+
+	EditJournal(EditJournal&&) = delete;
+	EditJournal(const EditJournal&) = delete;
+	EditJournal operator=(EditJournal&&) = delete;
+	EditJournal operator=(const EditJournal&) = delete;
+
+	void recordEdit(ChunkPos chunkPos, ChunkLocalBlockPos blockPos, Block block);
+	// Drops the edits of a chunk which has been written out in full
+	void recordCheckpoint(ChunkPos chunkPos);
+	// Writes pending records to the file, and rewrites the file once most of it is superseded records
+	void flush();
+
+	// Null if the chunk has no edits since it was last checkpointed
+	const ChunkEdits* getEdits(ChunkPos chunkPos) const;
+	const std::unordered_map<ChunkPos, ChunkEdits>& getAllEdits() const;
+};
@@ -0,0 +1,244 @@
+#include "RegionFile.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+
+namespace {
+
+constexpr u32 REGION_FILE_MAGIC = 0x47525652; // "RVRG"
+constexpr u32 REGION_FILE_VERSION = 1;
+
+
+
+size_t regionIndex(ChunkPos pos) {
+	constexpr i32 MASK = REGION_SIZE - 1;
+	return static_cast<size_t>(
+		((pos.getX() & MASK) << (2 * REGION_SIZE_LOG)) | ((pos.getY() & MASK) << REGION_SIZE_LOG) | (pos.getZ() & MASK)
+	);
+}
+
+
+
+void writeAll(int fd, const void* data, size_t size, u64 offset) {
+	const auto* bytes = static_cast<const u8*>(data);
+	while (size) {
+		ssize_t written = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+		if (written <= 0) throw std::runtime_error("Failed to write region file");
+		bytes += written;
+		size -= static_cast<size_t>(written);
+		offset += static_cast<u64>(written);
+	}
+}
+
+
+
+void syncFile(int fd) {
+	if (fdatasync(fd) != 0) throw std::runtime_error("Failed to sync region file");
+}
+
+
+
+// Makes a file created or renamed in the directory survive a crash
+void syncDirectory(const std::string& path) {
+	std::filesystem::path directory = std::filesystem::path(path).parent_path();
+	if (directory.empty()) directory = ".";
+	int directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+	if (directoryFd == -1) throw std::runtime_error("Failed to open directory of region file " + path);
+	const bool synced = fsync(directoryFd) == 0;
+	::close(directoryFd);
+	if (!synced) throw std::runtime_error("Failed to sync directory of region file " + path);
+}
+
+}
+
+
+
+RegionFile::RegionFile(std::string _path) : path{std::move(_path)} {
+	open(false);
+}
+
+
+
+RegionFile::~RegionFile() {
+	close();
+}
+
+
+
+// Files are only created once a chunk is written to them, so looking up chunks in a region that was never written to
+// leaves nothing behind
+void RegionFile::open(bool forWriting) {
+	header = {};
+	fileSize = 0;
+	liveSize = 0;
+	fd = ::open(path.c_str(), forWriting ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+	if (fd == -1) {
+		if (!forWriting && errno == ENOENT) return;
+		throw std::runtime_error("Failed to open region file " + path);
+	}
+	writable = forWriting;
+
+	struct stat fileStat{};
+	if (fstat(fd, &fileStat) != 0) {
+		close();
+		throw std::runtime_error("Failed to read region file " + path);
+	}
+	fileSize = static_cast<u64>(fileStat.st_size);
+
+	// New files get an empty header, anything else has to be a region file that this version can read
+	if (fileSize == 0) {
+		header.magic = REGION_FILE_MAGIC;
+		header.version = REGION_FILE_VERSION;
+		if (writable) {
+			writeAll(fd, &header, sizeof(header), 0);
+			fileSize = sizeof(header);
+			syncFile(fd);
+			syncDirectory(path);
+		}
+	}
+	else if (
+		fileSize < sizeof(header) ||
+		pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+		header.magic != REGION_FILE_MAGIC ||
+		header.version != REGION_FILE_VERSION
+	) {
+		close();
+		throw std::runtime_error("Invalid region file " + path);
+	}
+
+	// Entries pointing outside of the file are left over from a write that never finished, and are ignored
+	liveSize = 0;
+	for (auto& entry : header.entries) {
+		if (entry.offset < sizeof(header) || entry.offset + entry.size > fileSize) entry = {};
+		liveSize += entry.size;
+	}
+}
+
+
+
+void RegionFile::close() {
+	if (mapping) munmap(const_cast<u8*>(mapping), mappingSize);
+	mapping = nullptr;
+	mappingSize = 0;
+	if (fd != -1) ::close(fd);
+	fd = -1;
+	writable = false;
+}
+
+
+
+void RegionFile::remap() {
+	if (mapping) munmap(const_cast<u8*>(mapping), mappingSize);
+	mapping = nullptr;
+	mappingSize = 0;
+
+	void* result = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+	if (result == MAP_FAILED) throw std::runtime_error("Failed to map region file " + path);
+	mapping = static_cast<const u8*>(result);
+	mappingSize = fileSize;
+}
+
+
+
+bool RegionFile::hasChunk(ChunkPos pos) const {
+	return header.entries[regionIndex(pos)].size != 0;
+}
+
+
+
+std::span<const u8> RegionFile::readChunk(ChunkPos pos) {
+	const Entry& entry = header.entries[regionIndex(pos)];
+	if (!entry.size) return {};
+
+	// The mapping is only extended once something written since it was created is read
+	if (entry.offset + entry.size > mappingSize) remap();
+	return std::span<const u8>(mapping + entry.offset, entry.size);
+}
+
+
+
+void RegionFile::writeChunk(ChunkPos pos, std::span<const u8> data) {
+	if (!writable) {
+		close();
+		open(true);
+	}
+
+	const size_t index = regionIndex(pos);
+	const Entry entry{fileSize, data.size()};
+	writeAll(fd, data.data(), data.size(), entry.offset);
+	fileSize += data.size();
+
+	liveSize = liveSize - header.entries[index].size + entry.size;
+	header.entries[index] = entry;
+	unsyncedEntries.push_back(index);
+}
+
+
+
+// The payloads are on disk before any header entry points to them
+void RegionFile::sync() {
+	if (unsyncedEntries.empty()) return;
+	syncFile(fd);
+	for (const size_t index : unsyncedEntries) {
+		writeAll(fd, &header.entries[index], sizeof(Entry), offsetof(Header, entries) + index * sizeof(Entry));
+	}
+	syncFile(fd);
+	unsyncedEntries.clear();
+}
+
+
+
+// The compacted file is written next to the original and renamed over it, so the original is intact until the new
+// file is complete and on disk
+void RegionFile::compact() {
+	if (mappingSize < fileSize) remap();
+
+	std::string temporaryPath = path + ".tmp";
+	int temporaryFd = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (temporaryFd == -1) throw std::runtime_error("Failed to create region file " + temporaryPath);
+
+	try {
+		Header compactedHeader = header;
+		u64 offset = sizeof(Header);
+		for (auto& entry : compactedHeader.entries) {
+			if (!entry.size) continue;
+			writeAll(temporaryFd, mapping + entry.offset, entry.size, offset);
+			entry.offset = offset;
+			offset += entry.size;
+		}
+		writeAll(temporaryFd, &compactedHeader, sizeof(compactedHeader), 0);
+		syncFile(temporaryFd);
+	}
+	catch (const std::exception&) {
+		::close(temporaryFd);
+		std::remove(temporaryPath.c_str());
+		throw;
+	}
+	::close(temporaryFd);
+
+	if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+		std::remove(temporaryPath.c_str());
+		throw std::runtime_error("Failed to replace region file " + path);
+	}
+	syncDirectory(path);
+	// The compacted header includes every entry that hadn't been synced yet
+	unsyncedEntries.clear();
+	const bool _writable = writable;
+	close();
+	open(_writable);
+}
+
+
+
+u64 RegionFile::getFileSize() const { return fileSize; }
+u64 RegionFile::getDeadSize() const { return fileSize < sizeof(Header) ? 0 : fileSize - sizeof(Header) - liveSize; }
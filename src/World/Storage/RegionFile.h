@@ -0,0 +1,78 @@
+#pragma once
+#include <array>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../ChunkPos.h"
+
+
+
+constexpr i32 REGION_SIZE_LOG = 4;
+constexpr i32 REGION_SIZE = 1 << REGION_SIZE_LOG;
+constexpr i32 REGION_VOLUME = 1 << (3 * REGION_SIZE_LOG);
+
+
+
+/*
+A region file stores the chunks in a REGION_SIZE cube. The file starts with a header holding the offset and size of
+every chunk payload, followed by the payloads themselves. Payloads are only ever appended, and the header entry is
+only written to disk by sync, after the payloads it points to are on disk, so a write that is cut short leaves the
+previous version of the chunk in place. Until then the chunk can be read back, but isn't stored if the file is closed.
+Rewritten chunks leave dead space behind, which is removed by compacting the file. The file is opened read only until
+a chunk is written, and only created then. Reads go through a read only memory mapping of the whole file, which is
+only made once a chunk is read.
+*/
+class RegionFile {
+public:
+	struct Entry {
+		u64 offset;
+		u64 size;
+	};
+
+	struct Header {
+		u32 magic;
+		u32 version;
+		std::array<Entry, REGION_VOLUME> entries;
+	};
+
+private:
+	std::string path;
+	int fd = -1;
+	bool writable = false;
+	const u8* mapping = nullptr;
+	u64 mappingSize = 0;
+	u64 fileSize = 0;
+	// Bytes used by the payloads that the header points to
+	u64 liveSize = 0;
+	Header header{};
+	// Header entries which have been updated since the last sync, and are only written to the file by it
+	std::vector<size_t> unsyncedEntries;
+
+private:
+	void open(bool forWriting);
+	void close();
+	void remap();
+
+public:
+	RegionFile(std::string _path);
+	~RegionFile();
+
+	RegionFile(RegionFile&&) = delete;
+	RegionFile(const RegionFile&) = delete;
+	RegionFile operator=(RegionFile&&) = delete;
+	RegionFile operator=(const RegionFile&) = delete;
+
+	bool hasChunk(ChunkPos pos) const;
+	// Empty if the chunk isn't stored, the data is only valid until the next write or compaction
+	std::span<const u8> readChunk(ChunkPos pos);
+	// Appends the chunk, which is only stored once the file is synced
+	void writeChunk(ChunkPos pos, std::span<const u8> data);
+	// Puts every chunk written so far on disk, with one sync for all of the payloads and one for the header
+	void sync();
+	// Rewrites the file without the space left behind by rewritten chunks
+	void compact();
+
+	u64 getFileSize() const;
+	u64 getDeadSize() const;
+};
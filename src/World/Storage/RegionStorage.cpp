@@ -0,0 +1,159 @@
+#include "RegionStorage.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../../GlobalLog.h"
+#include "../../Profiling/Trace.h"
+
+
+
+namespace {
+
+// Regions are compacted when they are closed if at least this much of the file, and over half of it, is dead space
+constexpr u64 COMPACT_MIN_DEAD_SIZE = 1 << 20;
+
+
+
+ChunkPos regionPosition(const ChunkPos chunkPos) {
+	return ChunkPos(
+		chunkPos.getX() >> REGION_SIZE_LOG,
+		chunkPos.getY() >> REGION_SIZE_LOG,
+		chunkPos.getZ() >> REGION_SIZE_LOG
+	);
+}
+
+}
+
+
+
+RegionStorage::RegionStorage(std::filesystem::path _directory) : directory{std::move(_directory)} {
+	std::filesystem::create_directories(directory);
+}
+
+
+
+RegionStorage::~RegionStorage() {
+	for (auto& [_regionPos, region] : regions) {
+		if (region) closeRegion(_regionPos, *region);
+	}
+}
+
+
+
+RegionFile* RegionStorage::getRegion(const ChunkPos chunkPos) {
+	ChunkPos _regionPos = regionPosition(chunkPos);
+	auto region = regions.find(_regionPos);
+	if (region != regions.end()) return region->second.get();
+
+	std::string fileName = (
+		"r." + std::to_string(_regionPos.getX()) + "." + std::to_string(_regionPos.getY()) + "." +
+		std::to_string(_regionPos.getZ()) + ".rvr"
+	);
+	std::unique_ptr<RegionFile> regionFile;
+	try {
+		regionFile = std::make_unique<RegionFile>((directory / fileName).string());
+	}
+	catch (const std::exception& e) {
+		LOG_WARNING(std::string("Failed to open region: ") + e.what());
+	}
+	return regions.emplace(_regionPos, std::move(regionFile)).first->second.get();
+}
+
+
+
+void RegionStorage::closeRegion(const ChunkPos regionPos, RegionFile& region) {
+	try {
+		region.sync();
+	}
+	catch (const std::exception& e) {
+		LOG_WARNING(std::string("Failed to sync region: ") + e.what());
+	}
+	if (region.getDeadSize() < COMPACT_MIN_DEAD_SIZE || region.getDeadSize() * 2 < region.getFileSize()) return;
+
+	TRACE_ZONE("RegionStorage::compact");
+	try {
+		region.compact();
+	}
+	catch (const std::exception& e) {
+		LOG_WARNING(
+			"Failed to compact region " + std::to_string(regionPos.getX()) + " " + std::to_string(regionPos.getY()) +
+			" " + std::to_string(regionPos.getZ()) + ": " + e.what()
+		);
+	}
+}
+
+
+
+bool RegionStorage::hasChunk(const ChunkPos chunkPos) {
+	RegionFile* region = getRegion(chunkPos);
+	return region && region->hasChunk(chunkPos);
+}
+
+
+
+std::span<const u8> RegionStorage::readChunk(const ChunkPos chunkPos) {
+	RegionFile* region = getRegion(chunkPos);
+	return region ? region->readChunk(chunkPos) : std::span<const u8>();
+}
+
+
+
+bool RegionStorage::writeChunk(const ChunkPos chunkPos, std::span<const u8> data) {
+	RegionFile* region = getRegion(chunkPos);
+	if (!region) return false;
+	try {
+		region->writeChunk(chunkPos, data);
+	}
+	catch (const std::exception& e) {
+		LOG_WARNING(std::string("Failed to save chunk: ") + e.what());
+		return false;
+	}
+	return true;
+}
+
+
+
+bool RegionStorage::sync() {
+	TRACE_ZONE("RegionStorage::sync");
+	bool synced = true;
+	for (auto& [_regionPos, region] : regions) {
+		if (!region) continue;
+		try {
+			region->sync();
+		}
+		catch (const std::exception& e) {
+			LOG_WARNING(std::string("Failed to sync region: ") + e.what());
+			synced = false;
+		}
+	}
+	return synced;
+}
+
+
+
+void RegionStorage::closeDistantRegions(const ChunkPos centre, i64 distanceHorizontal, i64 distanceVertical) {
+	TRACE_ZONE("RegionStorage::closeDistantRegions");
+	// A region's centre is never more than a region size from any chunk in it, horizontally or vertically
+	ChunkPos2D _centre2D(centre);
+	const i64 _closeDistanceHorizontal = distanceHorizontal + REGION_SIZE;
+	const i64 _closeDistanceVertical = distanceVertical + REGION_SIZE;
+
+	std::vector<ChunkPos> closed;
+	for (auto& [_regionPos, region] : regions) {
+		ChunkPos _regionCentre(
+			(_regionPos.getX() << REGION_SIZE_LOG) + REGION_SIZE / 2,
+			(_regionPos.getY() << REGION_SIZE_LOG) + REGION_SIZE / 2,
+			(_regionPos.getZ() << REGION_SIZE_LOG) + REGION_SIZE / 2
+		);
+		if (
+			_centre2D.distanceEuclideanSquared(_regionCentre) > _closeDistanceHorizontal * _closeDistanceHorizontal ||
+			std::abs(centre.getY() - _regionCentre.getY()) > _closeDistanceVertical
+		) {
+			if (region) closeRegion(_regionPos, *region);
+			closed.push_back(_regionPos);
+		}
+	}
+	for (auto& _regionPos : closed) regions.erase(_regionPos);
+}
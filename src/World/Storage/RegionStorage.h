@@ -0,0 +1,40 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <unordered_map>
+
+#include "RegionFile.h"
+
+
+
+// Keeps the region files around the player open, and routes chunk reads and writes to the region containing them
+class RegionStorage {
+private:
+	std::filesystem::path directory;
+	// Region files by region position, null for regions which couldn't be opened so that they aren't retried
+	std::unordered_map<ChunkPos, std::unique_ptr<RegionFile>> regions;
+
+private:
+	RegionFile* getRegion(const ChunkPos chunkPos);
+	void closeRegion(const ChunkPos regionPos, RegionFile& region);
+
+public:
+	RegionStorage(std::filesystem::path _directory);
+	~RegionStorage();
+
+	RegionStorage(RegionStorage&&) = delete;
+	RegionStorage(const RegionStorage&) = delete;
+	RegionStorage operator=(RegionStorage&&) = delete;
+	RegionStorage operator=(const RegionStorage&) = delete;
+
+	bool hasChunk(const ChunkPos chunkPos);
+	// Empty if the chunk isn't stored, the data is only valid until the next write to storage
+	std::span<const u8> readChunk(const ChunkPos chunkPos);
+	// Returns whether the chunk was written, failures are logged. It is only on disk after the next sync.
+	bool writeChunk(const ChunkPos chunkPos, std::span<const u8> data);
+	// Puts every chunk written so far on disk, returns whether all of them are, failures are logged
+	bool sync();
+	// Closes the regions which can't contain chunks within the given distances of the centre
+	void closeDistantRegions(const ChunkPos centre, i64 distanceHorizontal, i64 distanceVertical);
+};
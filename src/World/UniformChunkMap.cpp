@@ -0,0 +1,49 @@
+#include "UniformChunkMap.h"
+
+
+
+void UniformChunkMap::insert(ChunkPos pos, Block block) {
+	blocks.insert_or_assign(pos, block);
+	auto& sharedChunk = sharedChunks[block.blockType];
+	if (!sharedChunk) {
+		sharedChunk = std::make_unique<Chunk>(ChunkPos(0, 0, 0));
+		sharedChunk->fillUniform(block);
+	}
+}
+
+
+
+std::optional<Block> UniformChunkMap::erase(ChunkPos pos) {
+	auto it = blocks.find(pos);
+	if (it == blocks.end()) return std::nullopt;
+	Block block = it->second;
+	blocks.erase(it);
+	return block;
+}
+
+
+
+// The shared chunks are kept, there are only ever a handful of them
+void UniformChunkMap::clear() {
+	blocks.clear();
+}
+
+
+
+bool UniformChunkMap::contains(ChunkPos pos) const {
+	return blocks.contains(pos);
+}
+
+
+
+const std::unique_ptr<Chunk>* UniformChunkMap::getChunk(ChunkPos pos) const {
+	auto it = blocks.find(pos);
+	if (it == blocks.end()) return nullptr;
+	return &sharedChunks.at(it->second.blockType);
+}
+
+
+
+size_t UniformChunkMap::size() const {
+	return blocks.size();
+}
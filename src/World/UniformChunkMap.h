@@ -0,0 +1,40 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+#include "Block.h"
+#include "Chunk.h"
+#include "ChunkPos.h"
+
+
+
+/*
+Chunks made of a single block with nothing left to populate, such as the sky and deep underground, are stored as just
+that block instead of a Chunk each. Reads go through a read only chunk shared by every uniform chunk of the same
+block, and a uniform chunk has to be taken out of the map and made into a real chunk before anything writes to it.
+*/
+class UniformChunkMap {
+private:
+	std::unordered_map<ChunkPos, Block> blocks;
+	// Stand-ins for every uniform chunk of each block type, their position is meaningless
+	std::unordered_map<i32, std::unique_ptr<Chunk>> sharedChunks;
+
+public:
+	UniformChunkMap() = default;
+
+	UniformChunkMap(UniformChunkMap&&) = delete;
+	UniformChunkMap(const UniformChunkMap&) = delete;
+	UniformChunkMap operator=(UniformChunkMap&&) = delete;
+	UniformChunkMap operator=(const UniformChunkMap&) = delete;
+
+	void insert(ChunkPos pos, Block block);
+	// Returns the block of the removed chunk, if there was one
+	std::optional<Block> erase(ChunkPos pos);
+	void clear();
+
+	bool contains(ChunkPos pos) const;
+	// The shared chunk standing in for the chunk at the position, or null if it isn't uniform
+	const std::unique_ptr<Chunk>* getChunk(ChunkPos pos) const;
+	size_t size() const;
+};
@@ -1,24 +1,37 @@
 #include "World.h"
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <filesystem>
+#include <optional>
+#include <string>
 
-#include "Physics.h"
+#include <glm/geometric.hpp>
+
+#include "BlockRegistry.h"
+#include "SlabPool.h"
 #include "../Exceptions.h"
 #include "../GlobalLog.h"
+#include "../Profiling/Trace.h"
 
 
 
-constexpr int SEED = 24383737;
+// The chunk queues are reordered when the view direction has turned by more than about 30 degrees
+constexpr double REPRIORITISE_VIEW_ALIGNMENT = 0.866;
+// Unloaded chunk objects kept for reuse, and how many unloaded chunks have their memory freed each tick
+constexpr size_t CHUNK_POOL_CAPACITY = 1024;
+constexpr size_t CHUNK_RELEASE_COUNT = 64;
+// Radius in chunks of the area which has to be ready before the loading screen is hidden
+constexpr i32 LOADING_REGION_RADIUS = 4;
+// Chunks with this many edited blocks are written out in full instead of being kept as edits, which is checked every
+// minute for loaded chunks and whenever a chunk is unloaded
+constexpr size_t CHECKPOINT_EDIT_COUNT = 1024;
+constexpr u64 CHECKPOINT_INTERVAL_TICKS = 3000;
 
 
 namespace {
 
-int chunkLoadPriority(ChunkPos pos, ChunkPos centre) {
-	return std::clamp(200 - static_cast<int>(centre.distanceEuclidean(pos)), 0, 200);
-}
-
-
-
 inline int sign(double x) {
 	return (0.0 < x) - (x < 0.0);
 }
@@ -59,42 +72,99 @@ constexpr int CHUNK_NEIGHBOURHOOD[27][3] = {
 
 
 
-constexpr int CHUNK_NEIGHBOURS_CARDINAL[6][3] = {
-	{ 1,  0,  0},
-	{-1,  0,  0},
-	{ 0,  1,  0},
-	{ 0, -1,  0},
-	{ 0,  0,  1},
-	{ 0,  0, -1}
-};
-
-
-
 World::World(
 	const Settings& _settings,
-	std::shared_ptr<SharedGameRendererState> _sharedRendererState,
-	const char* settingNoiseHeightmap
+	std::shared_ptr<SharedGameRendererState> _sharedRendererState
 ) :
 	settings{_settings},
 	loadCentre(0, 1, 0),
+	loadOrder(settings.getLoadDistanceHorizontal(), settings.getLoadDistanceVertical()),
+	chunkPool(CHUNK_POOL_CAPACITY),
+	chunkDeduplicator(settings.getChunkDeduplication()),
+	regionStorage(settings.getWorldPath()),
+	editJournal((std::filesystem::path(settings.getWorldPath()) / "journal.rvj").string()),
 	generatorChunkNoise(
-		SEED,
-		settingNoiseHeightmap,
-		"KQkNCQY@CRRQ=",
-		"KQkNCQY@CRRQ="
+		WORLD_SEED,
+		NOISE_HEIGHTMAP,
+		NOISE_TEMPERATURE,
+		NOISE_RAINFALL
 	),
-	sharedRendererState{std::move(_sharedRendererState)}
+	sharedRendererState{std::move(_sharedRendererState)},
+	pipelineScheduler(
+		std::chrono::microseconds(static_cast<long long>(settings.getChunkPipelineBudgetMin() * 1000.0)),
+		std::chrono::microseconds(static_cast<long long>(settings.getChunkPipelineBudgetMax() * 1000.0)),
+		std::chrono::microseconds(static_cast<long long>(settings.getChunkPipelineTickReserve() * 1000.0))
+	)
 {
-	loadQueue.push(ChunkPriorityTicket(chunkLoadPriority(loadCentre, loadCentre), loadCentre));
-	chunkStatusMap.setChunkStatusLoad(loadCentre, StatusChunkLoad::QUEUED_LOAD);
-	GlobalLog.Write("Loaded World");
+	SlabPool::configure(settings.getPoolSlabSize(), settings.getPoolHugePages());
+	loadOrder.recentre(loadCentre, [](ChunkPos) { return false; });
+	LOG_INFO("Loaded World");
 }
 
 
 
-void World::tick(Entity& player) {
+World::~World() {
+	for (auto& [_pos, chunk] : mapChunks) checkpointChunk(*chunk);
+	syncCheckpoints();
+	LOG_INFO(
+		"Chunks loaded from storage: " + std::to_string(chunksLoadedFromStorage) +
+		", checkpointed: " + std::to_string(chunksCheckpointed)
+	);
+	LOG_INFO(
+		"Uniform chunks: " + std::to_string(chunksLoadedUniform) + " loaded without a chunk, " +
+		std::to_string(chunksMaterialised) + " materialised"
+	);
+
+	size_t _populationChangesBytes = 0;
+	for (const auto& [_pos, chunk] : mapChunks) _populationChangesBytes += chunk->getPopulationChangesByteSize();
+	LOG_INFO(
+		"Population changes: " + std::to_string(_populationChangesBytes / std::max<size_t>(mapChunks.size(), 1)) +
+		" bytes per loaded chunk, " + std::to_string(_populationChangesBytes / 1024) + "KiB total, " +
+		std::to_string(populationChangesRegenerated) + " regenerated"
+	);
+
+	for (const auto& _pool : SlabPool::getAllStats()) {
+		LOG_INFO(
+			std::string(_pool.name) + " pool: " + std::to_string(_pool.slotsInUse) + " in use, " +
+			std::to_string(_pool.slotsHighWater) + " high water, " + std::to_string(_pool.slotsReserved) +
+			" reserved in " + std::to_string(_pool.slabCount) + " slabs (" +
+			std::to_string(_pool.slabsOnHugePages) + " on huge pages)"
+		);
+	}
+
+	if (settings.getChunkDeduplication()) {
+		const auto& _stats = chunkDeduplicator.getStats();
+		LOG_INFO(
+			"Chunk deduplication: " + std::to_string(_stats.chunkHits) + "/" + std::to_string(_stats.chunkLookups) +
+			" chunks shared saving " + std::to_string(_stats.blockBytesSaved / 1024) + "KiB, " +
+			std::to_string(_stats.meshHits) + "/" + std::to_string(_stats.meshLookups) + " meshes shared saving " +
+			std::to_string(_stats.meshBytesSaved / 1024) + "KiB"
+		);
+	}
+}
+
+
+
+void World::tick(Entity& player, const SimulationClock& simulationClock) {
+	TRACE_ZONE("World::tick");
+	WorldProfiler::TickRecord tickRecord{};
+	tickRecord.tick = simulationClock.getTick();
+	tickRecord.slipMicroseconds = static_cast<uint32_t>(simulationClock.getSlip().count());
+	auto timeTickBegin = std::chrono::steady_clock::now();
+	auto timeStageBegin = timeTickBegin;
+	auto endStage = [&](WorldProfiler::Stage stage, uint32_t itemCount) {
+		auto timeNow = std::chrono::steady_clock::now();
+		auto stageIndex = static_cast<size_t>(stage);
+		tickRecord.stageMicroseconds[stageIndex] = static_cast<uint32_t>(
+			std::chrono::duration_cast<std::chrono::microseconds>(timeNow - timeStageBegin).count()
+		);
+		tickRecord.itemCounts[stageIndex] = itemCount;
+		timeStageBegin = timeNow;
+	};
+
 	std::queue<ChunkPos> meshUnloadQueue;
 	sharedRendererState->chunkMeshQueueDeletion->getQueue(meshUnloadQueue);
+	auto meshUnloadCount = static_cast<uint32_t>(meshUnloadQueue.size());
 	while (!meshUnloadQueue.empty()) {
 		ChunkPos _pos = meshUnloadQueue.front();
 		meshUnloadQueue.pop();
@@ -103,17 +173,52 @@ void World::tick(Entity& player) {
 		}
 	}
 
+	endStage(WorldProfiler::Stage::MeshUnload, meshUnloadCount);
+
+	priorityView = ChunkPriorityView::fromEntity(player.position, SimulationClock::TICK_SECONDS);
 	ChunkPos _playerChunk(player.position);
-	if (_playerChunk != loadCentre) {
+	bool loadCentreChanged = _playerChunk != loadCentre;
+	if (loadCentreChanged) {
+		ChunkPos previousLoadCentre = loadCentre;
 		loadCentre = _playerChunk;
-		onLoadCentreChange();
+		if (loadRegionsOverlap(previousLoadCentre, loadCentre)) onLoadCentreChange();
+		else onLoadCentreTeleport();
 	}
+	// Priorities are fixed when chunks are queued, so they are recalculated once the view has turned far enough
+	else if (glm::dot(priorityView.forward, priorityViewQueued.forward) < REPRIORITISE_VIEW_ALIGNMENT) {
+		rebuildChunkQueues();
+	}
+	endStage(WorldProfiler::Stage::LoadCentreChange, loadCentreChanged);
 
-	loadChunks();
-	populateChunks();
-	meshChunks();
+	runChunkPipeline(simulationClock, tickRecord);
+	chunkPool.processReleased(CHUNK_RELEASE_COUNT);
+	if (loadingRegionSize) updateLoadingProgress();
+	if (simulationClock.getTick() % CHECKPOINT_INTERVAL_TICKS == 0) checkpointEditedChunks();
+	try {
+		editJournal.flush();
+	}
+	catch (const std::exception& e) {
+		LOG_WARNING(std::string("Failed to save edits: ") + e.what());
+	}
+	timeStageBegin = std::chrono::steady_clock::now();
 
 	processEntities(player);
+	endStage(WorldProfiler::Stage::Entities, static_cast<uint32_t>(mapEntities.size() + 1));
+
+	tickRecord.loadQueueDepth = static_cast<uint32_t>(loadOrder.getRemaining());
+	tickRecord.populateQueueDepth = static_cast<uint32_t>(populateQueue.size());
+	tickRecord.meshQueueDepth = static_cast<uint32_t>(meshQueue.size());
+	tickRecord.meshUploadQueueDepth = static_cast<uint32_t>(sharedRendererState->chunkMeshQueue->getSize());
+	TRACE_COUNTER("Load queue", tickRecord.loadQueueDepth);
+	TRACE_COUNTER("Populate queue", tickRecord.populateQueueDepth);
+	TRACE_COUNTER("Mesh queue", tickRecord.meshQueueDepth);
+	TRACE_COUNTER("Mesh upload queue", tickRecord.meshUploadQueueDepth);
+	sharedRendererState->worldProfiler.recordTick(tickRecord);
+
+	pipelineScheduler.endTick(
+		std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - timeTickBegin),
+		SimulationClock::TICK_INTERVAL
+	);
 }
 
 
@@ -124,13 +229,19 @@ Block World::getBlock(BlockPos blockPos) const {
 
 
 
-void World::setBlock(BlockPos blockPos, Block block) const {
-	getChunk(ChunkPos(blockPos))->setBlock(ChunkLocalBlockPos(blockPos), block);
+// Edits are journaled, so that they are applied again when the chunk is next loaded
+void World::setBlock(BlockPos blockPos, Block block) {
+	ChunkPos _chunkPos(blockPos);
+	ChunkLocalBlockPos _localPos(blockPos);
+	if (uniformChunks.contains(_chunkPos)) materialiseChunk(_chunkPos);
+	getChunk(_chunkPos)->setBlock(_localPos, block);
+	editJournal.recordEdit(_chunkPos, _localPos, block);
 }
 
 
 
 void World::processEntities(Entity& player) {
+	TRACE_ZONE("World::processEntities");
 	moveEntity(player);
 	for (auto& [UUID, entity] : mapEntities) {
 		moveEntity(entity);
@@ -170,6 +281,9 @@ void World::moveEntity(Entity& entity) {
 		((0 < stepZ) ? std::ceil(pos.pos.z) - pos.pos.z : pos.pos.z - std::floor(pos.pos.z)) * tDeltaZ :
 		1.0;
 
+	// Blocks the entity can reach this tick are nearly always within the chunks around where it starts
+	const ChunkNeighbourhood _neighbourhood = getPopulatedNeighbourhood(ChunkPos(currentPos));
+
 	const int _sx = static_cast<int>(std::ceil(entity.size.x * 2)) - 1;
 	const int _sy = static_cast<int>(std::ceil(entity.size.y))     - 1;
 	const int _sz = static_cast<int>(std::ceil(entity.size.z * 2)) - 1;
@@ -180,7 +294,7 @@ void World::moveEntity(Entity& entity) {
 				int lX = (stepX > 0) ? _sx : 0;
 				for (int lZ = 0; lZ < _sz; ++lZ) {
 				for (int lY = 0; lY < _sy; ++lY) {
-					if (blockIsCollidable(currentPos.offset(stepX + lX, lY, lZ))) goto Collided;
+					if (blockIsCollidable(_neighbourhood, currentPos.offset(stepX + lX, lY, lZ))) goto Collided;
 				}
 				}
 				tMaxX += tDeltaX;
@@ -190,7 +304,7 @@ void World::moveEntity(Entity& entity) {
 				int lZ = (stepZ > 0) ? _sz : 0;
 				for (int lY = 0; lY < _sy; ++lY) {
 				for (int lX = 0; lX < _sx; ++lX) {
-					if (blockIsCollidable(currentPos.offset(lX, lY, stepZ + lZ))) goto Collided;
+					if (blockIsCollidable(_neighbourhood, currentPos.offset(lX, lY, stepZ + lZ))) goto Collided;
 				}
 				}
 				tMaxZ += tDeltaZ;
@@ -201,7 +315,7 @@ void World::moveEntity(Entity& entity) {
 			int lY = (stepY > 0) ? _sy : 0;
 			for (int lX = 0; lX < _sx; ++lX) {
 			for (int lZ = 0; lZ < _sz; ++lZ) {
-				if (blockIsCollidable(currentPos.offset(lX, stepY + lY, lZ))) goto Collided;
+				if (blockIsCollidable(_neighbourhood, currentPos.offset(lX, stepY + lY, lZ))) goto Collided;
 			}
 			}
 			tMaxY += tDeltaY;
@@ -211,7 +325,7 @@ void World::moveEntity(Entity& entity) {
 			int lZ = (stepZ > 0) ? _sz : 0;
 			for (int lY = 0; lY < _sy; ++lY) {
 			for (int lX = 0; lX < _sx; ++lX) {
-				if (blockIsCollidable(currentPos.offset(lX, lY, stepZ + lZ))) goto Collided;
+				if (blockIsCollidable(_neighbourhood, currentPos.offset(lX, lY, stepZ + lZ))) goto Collided;
 			}
 			}
 			tMaxZ += tDeltaZ;
@@ -231,43 +345,89 @@ bool World::blockIsCollidable(BlockPos blockPos) const {
 	if (chunkStatusMap.getChunkStatusLoad(ChunkPos(blockPos)) != StatusChunkLoad::POPULATED) {
 		return true;
 	}
-	return Physics::IS_COLLIDABLE[getBlock(blockPos).blockType];
+	return BlockRegistry::isCollidable(getBlock(blockPos));
+}
+
+
+
+// Positions outside of the neighbourhood fall back to looking up the block in the world
+bool World::blockIsCollidable(const ChunkNeighbourhood& neighbourhood, BlockPos blockPos) const {
+	const ChunkPos _centre = neighbourhood.getCentre();
+	const BlockOffset _offset = BlockPos(
+		_centre.getX() * CHUNK_SIZE,
+		_centre.getY() * CHUNK_SIZE,
+		_centre.getZ() * CHUNK_SIZE
+	).distance(blockPos);
+	const i32 _x = _offset.getX();
+	const i32 _y = _offset.getY();
+	const i32 _z = _offset.getZ();
+
+	if (!ChunkNeighbourhood::inRange(_x, _y, _z)) return blockIsCollidable(blockPos);
+	if (!neighbourhood.hasChunk(_x, _y, _z)) return true;
+	return BlockRegistry::isCollidable(neighbourhood.getBlock(_x, _y, _z));
+}
+
+
+
+// Chunks which aren't populated are left out, as their blocks aren't final
+ChunkNeighbourhood World::getPopulatedNeighbourhood(const ChunkPos centre) const {
+	std::array<const Chunk*, 27> _chunks{};
+	for (i32 dx = -1; dx <= 1; ++dx) {
+	for (i32 dy = -1; dy <= 1; ++dy) {
+	for (i32 dz = -1; dz <= 1; ++dz) {
+		const ChunkPos _pos(centre.getX() + dx, centre.getY() + dy, centre.getZ() + dz);
+		if (chunkStatusMap.getChunkStatusLoad(_pos) == StatusChunkLoad::POPULATED) {
+			_chunks[ChunkNeighbourhood::getOffsetIndex(dx, dy, dz)] = getChunk(_pos).get();
+		}
+	}
+	}
+	}
+	return ChunkNeighbourhood(centre, _chunks);
 }
 
 
 
 void World::onLoadCentreChange() {
+	TRACE_ZONE("World::onLoadCentreChange");
 	// Jesus christ this function might just be hands down one of the worst pieces of code I have ever written
 	// There is an unbelievable amount of things that could be optimised, done better or probably done without
 	// I pray to god that this never breaks because I sure as hell do not know how it works.
 	// Update: well fuck, it doesn't quite work
 
+	// Chunks are only unloaded once they are a margin beyond the load distance, so that moving back and forth across
+	// a chunk border doesn't keep unloading and regenerating the same chunks
 	ChunkPos2D _loadCentre2D(loadCentre);
-	const long long _loadDistanceHorizontalSquared = (
-		static_cast<long long>(settings.getLoadDistanceHorizontal()) *
-		settings.getLoadDistanceHorizontal()
-	);
+	const long long _unloadDistanceHorizontal = settings.getLoadDistanceHorizontal() + settings.getUnloadMargin();
+	const long long _unloadDistanceHorizontalSquared = _unloadDistanceHorizontal * _unloadDistanceHorizontal;
+	const long long _unloadDistanceVertical = settings.getLoadDistanceVertical() + settings.getUnloadMargin();
 
 	// Pass 1: unload all chunks that should be unloaded
 	std::vector<ChunkPos> unloadQueue;
 	for (auto& [_pos, _status] : chunkStatusMap.statusMap) {
 		if (
-			_loadCentre2D.distanceEuclideanSquared(_pos) > _loadDistanceHorizontalSquared ||
-			std::abs(loadCentre.getY() - _pos.getY()) > settings.getLoadDistanceVertical()
+			_loadCentre2D.distanceEuclideanSquared(_pos) > _unloadDistanceHorizontalSquared ||
+			std::abs(loadCentre.getY() - _pos.getY()) > _unloadDistanceVertical
 		) {
 			unloadQueue.push_back(_pos);
 		}
 	}
 
-	// Actually unload them
+	// Actually unload them, the chunk memory is freed gradually by the pool
 	for (auto& _pos : unloadQueue) {
+		// Checkpointed while the chunk is still marked as populated, as only populated chunks are checkpointed
+		if (!uniformChunks.erase(_pos)) {
+			auto chunk = mapChunks.find(_pos);
+			checkpointChunk(*chunk->second);
+			chunkPool.release(std::move(chunk->second));
+			mapChunks.erase(chunk);
+		}
 		chunkStatusMap.setChunkStatusLoad(_pos, StatusChunkLoad::NON_EXISTENT);
-		mapChunks.erase(_pos);
 		// Check if cached generation data can be cleared
-		if (_loadCentre2D.distanceEuclideanSquared(_pos) > _loadDistanceHorizontalSquared) {
+		if (_loadCentre2D.distanceEuclideanSquared(_pos) > _unloadDistanceHorizontalSquared) {
 			generatorChunkCache.erase(ChunkPos2D(_pos));
 		}
 	}
+	syncCheckpoints();
 
 	// Figure out wtf is going on with the rest of the chunks
 	for (auto& [_pos, _status] : chunkStatusMap.statusMap) {
@@ -277,19 +437,6 @@ void World::onLoadCentreChange() {
 			if (chunkStatusMap.getChunkStatusCanPopulate(_pos)) {
 				chunkStatusMap.setChunkStatusLoad(_pos, StatusChunkLoad::QUEUED_POPULATE);
 			}
-			[[fallthrough]];
-		case StatusChunkLoad::POPULATED:
-			// Check if any neighbours should be loaded
-			for (auto [lX, lY, lZ] : CHUNK_NEIGHBOURS_CARDINAL) {
-				ChunkPos nPos(_pos.getX() + lX, _pos.getY() + lY, _pos.getZ() + lZ);
-				if (
-					_loadCentre2D.distanceEuclideanSquared(_pos) <= _loadDistanceHorizontalSquared &&
-					std::abs(loadCentre.getY() - _pos.getY()) <= settings.getLoadDistanceVertical() &&
-					chunkStatusMap.getChunkStatusLoad(nPos) == StatusChunkLoad::NON_EXISTENT
-				) {
-					chunkStatusMap.setChunkStatusLoad(nPos, StatusChunkLoad::QUEUED_LOAD);
-				}
-			}
 			break;
 
 		case StatusChunkLoad::QUEUED_POPULATE:
@@ -310,65 +457,240 @@ void World::onLoadCentreChange() {
 		}
 	}
 
-	// Re generate all chunk queues
-	loadQueue = std::priority_queue<ChunkPriorityTicket>();
+	// Chunks still to be loaded are whatever the load table covers that doesn't exist yet
+	loadOrder.recentre(loadCentre, [&](ChunkPos pos) { return chunkStatusMap.chunkExists(pos); });
+
+	rebuildChunkQueues();
+	closeDistantRegions();
+}
+
+
+
+bool World::loadRegionsOverlap(const ChunkPos centreA, const ChunkPos centreB) const {
+	const long long _unloadDistanceHorizontal = settings.getLoadDistanceHorizontal() + settings.getUnloadMargin();
+	const long long _unloadDistanceVertical = settings.getLoadDistanceVertical() + settings.getUnloadMargin();
+	return (
+		ChunkPos2D(centreA).distanceEuclideanSquared(centreB) <= 4 * _unloadDistanceHorizontal * _unloadDistanceHorizontal &&
+		std::abs(centreA.getY() - centreB.getY()) <= 2 * _unloadDistanceVertical
+	);
+}
+
+
+
+// When the new load region doesn't overlap the old one every chunk would be unloaded anyway, so instead of diffing
+// the status map all of the world state is dropped at once and loading starts from scratch around the new centre
+void World::onLoadCentreTeleport() {
+	TRACE_ZONE("World::onLoadCentreTeleport");
+	std::vector<std::unique_ptr<Chunk>> droppedChunks;
+	droppedChunks.reserve(mapChunks.size());
+	for (auto& [_pos, chunk] : mapChunks) {
+		checkpointChunk(*chunk);
+		droppedChunks.push_back(std::move(chunk));
+	}
+	syncCheckpoints();
+	LOG_DEBUG("Load centre jumped, dropping " + std::to_string(droppedChunks.size()) + " chunks");
+
+	mapChunks.clear();
+	uniformChunks.clear();
+	chunkPool.releaseAll(std::move(droppedChunks));
+	chunkStatusMap.statusMap.clear();
+	mapStructures.clear();
+	generatorChunkCache.clear();
+
+	loadOrder.recentre(loadCentre, [](ChunkPos) { return false; });
+	rebuildChunkQueues();
+	closeDistantRegions();
+
+	loadingRegionSize = loadOrder.countWithin(LOADING_REGION_RADIUS);
+	updateLoadingProgress();
+}
+
+
+
+// Progress of loading the chunks closest to the player after a teleport, for the loading screen
+void World::updateLoadingProgress() {
+	size_t readyCount = 0;
+	for (size_t i = 0; i < loadingRegionSize; ++i) {
+		if (chunkStatusMap.getChunkStatusMesh(loadOrder.getPosition(i)) == StatusChunkMesh::MESHED) readyCount++;
+	}
+	if (readyCount == loadingRegionSize) loadingRegionSize = 0;
+
+	float progress = loadingRegionSize ? static_cast<float>(readyCount) / static_cast<float>(loadingRegionSize) : 1.0f;
+	sharedRendererState->loadingProgress.store(progress);
+}
+
+
+
+void World::rebuildChunkQueues() {
+	TRACE_ZONE("World::rebuildChunkQueues");
+	priorityViewQueued = priorityView;
 	populateQueue = std::priority_queue<ChunkPriorityTicket>();
 	meshQueue = std::priority_queue<ChunkPriorityTicket>();
 	for (auto& [_pos, _status] : chunkStatusMap.statusMap) {
-		if (_status.getLoadStatus() == StatusChunkLoad::QUEUED_LOAD) {
-			loadQueue.push(ChunkPriorityTicket(chunkLoadPriority(_pos, loadCentre), _pos));
-		}
-		else if (_status.getLoadStatus() == StatusChunkLoad::QUEUED_POPULATE) {
-			populateQueue.push(ChunkPriorityTicket(chunkLoadPriority(_pos, loadCentre), _pos));
+		if (_status.getLoadStatus() == StatusChunkLoad::QUEUED_POPULATE) {
+			populateQueue.push(ChunkPriorityTicket(getChunkPriority(_pos), _pos));
 		}
 		else if (_status.getMeshStatus() == StatusChunkMesh::QUEUED) {
-			meshQueue.push(ChunkPriorityTicket(chunkLoadPriority(_pos, loadCentre), _pos));
+			meshQueue.push(ChunkPriorityTicket(getChunkPriority(_pos), _pos));
 		}
 	}
 }
 
 
 
-void World::loadChunks() {
-	constexpr int MAX_LOAD_COUNT = 35;
-	for (int i = 0; !loadQueue.empty() && i < MAX_LOAD_COUNT; ++i) {
-		ChunkPos lPos = loadQueue.top().pos;
-		loadQueue.pop();
+// Runs the load, populate and mesh stages until this tick's time budget runs out. The stages share one priority
+// order, so the next item is always the most urgent one in any stage, with ties going to the stage closest to
+// producing a mesh
+void World::runChunkPipeline(const SimulationClock& simulationClock, WorldProfiler::TickRecord& tickRecord) {
+	TRACE_ZONE("World::runChunkPipeline");
+	using Stage = ChunkPipelineScheduler::Stage;
+	constexpr std::array<WorldProfiler::Stage, ChunkPipelineScheduler::STAGE_COUNT> PROFILER_STAGES = {
+		WorldProfiler::Stage::Load,
+		WorldProfiler::Stage::Populate,
+		WorldProfiler::Stage::Mesh
+	};
 
-		// Make sure that the chunk is queued for loading (something has gone horribly wrong if it isn't)
-		assert(
-			(chunkStatusMap.getChunkStatusLoad(lPos) == StatusChunkLoad::QUEUED_LOAD) &&
-			"Attempted to load already loaded chunk."
+	std::queue<std::unique_ptr<MeshChunk::Data>> meshDataQueue;
+	// Meshing is throttled by the free space in the renderer's queue, so when the renderer falls behind chunks stay
+	// queued here instead of piling up as mesh data that can't be uploaded yet. This is the only thread pushing
+	// meshes, so the free capacity can only grow until the merge below
+	const size_t meshLimit = sharedRendererState->chunkMeshQueue->getFreeCapacity();
+
+	auto budget = pipelineScheduler.beginTick(simulationClock.getTickDeadline());
+	tickRecord.chunkBudgetMicroseconds = static_cast<uint32_t>(budget.count());
+
+	std::array<std::chrono::microseconds, ChunkPipelineScheduler::STAGE_COUNT> stageTime{};
+	std::array<uint32_t, ChunkPipelineScheduler::STAGE_COUNT> stageCount{};
+	// Nothing else touches the load table during the pipeline, so the candidate holds until it is loaded
+	std::optional<ChunkPriorityTicket> loadCandidate = nextLoadCandidate();
+	for (bool firstItem = true;; firstItem = false) {
+		std::optional<Stage> stage;
+		double stagePriority = 0.0;
+		auto considerStage = [&](Stage candidate, const std::optional<ChunkPriorityTicket>& ticket) {
+			if (ticket && (!stage || ticket->priority > stagePriority)) {
+				stage = candidate;
+				stagePriority = ticket->priority;
+			}
+		};
+		auto queueTop = [](const std::priority_queue<ChunkPriorityTicket>& queue) {
+			return queue.empty() ? std::nullopt : std::optional<ChunkPriorityTicket>(queue.top());
+		};
+		if (meshDataQueue.size() < meshLimit) considerStage(Stage::Mesh, queueTop(meshQueue));
+		considerStage(Stage::Populate, queueTop(populateQueue));
+		considerStage(Stage::Load, loadCandidate);
+
+		// At least one item is always processed, so that slow machines still make progress
+		if (!stage || (!firstItem && !pipelineScheduler.canAfford(*stage))) break;
+
+		auto timeItemBegin = std::chrono::steady_clock::now();
+		switch (*stage) {
+		case Stage::Load:
+			loadChunk(loadCandidate->pos);
+			loadCandidate = nextLoadCandidate();
+			break;
+		case Stage::Populate:
+			populateChunk();
+			break;
+		case Stage::Mesh:
+			meshChunk(meshDataQueue);
+			break;
+		default:
+			break;
+		}
+		auto itemDuration = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - timeItemBegin
 		);
+		pipelineScheduler.recordItem(*stage, itemDuration);
+		stageTime[static_cast<size_t>(*stage)] += itemDuration;
+		stageCount[static_cast<size_t>(*stage)]++;
+	}
+
+	for (size_t i = 0; i < ChunkPipelineScheduler::STAGE_COUNT; ++i) {
+		auto profilerStage = static_cast<size_t>(PROFILER_STAGES[i]);
+		tickRecord.stageMicroseconds[profilerStage] = static_cast<uint32_t>(stageTime[i].count());
+		tickRecord.itemCounts[profilerStage] = stageCount[i];
+	}
+
+	// Push meshes, if any were created
+	if (meshDataQueue.size()) {
+		[[maybe_unused]] bool merged = sharedRendererState->chunkMeshQueue->mergeQueue(meshDataQueue);
+		assert(merged && "Chunk mesh queue overflowed despite throttling");
+	}
+}
+
 
-		// Load the chunk
-		auto insertRes = mapChunks.insert({ lPos, std::make_unique<Chunk>(lPos) });
-		chunkStatusMap.setChunkStatusLoad(lPos, StatusChunkLoad::LOADED);
 
-		// Generate the chunk
-		insertRes.first->second->GenerateChunk(getGeneratorChunkParameters(ChunkPos2D(lPos)));
+// Picks the most urgent of the next few chunks in the load table. The table is sorted by distance alone, so looking a
+// little way ahead lets the view direction and movement still reorder chunks at about the same distance
+std::optional<ChunkPriorityTicket> World::nextLoadCandidate() {
+	constexpr size_t LOAD_LOOKAHEAD = 32;
+	std::optional<ChunkPriorityTicket> candidate;
+	size_t candidateIndex = 0;
+	loadOrder.forEachPending(LOAD_LOOKAHEAD, [&](size_t index) {
+		ChunkPos pos = loadOrder.getPosition(index);
+		double priority = getChunkPriority(pos);
+		if (!candidate || priority > candidate->priority) {
+			candidate.emplace(priority, pos);
+			candidateIndex = index;
+		}
+	});
+	if (candidate) loadCandidateIndex = candidateIndex;
+	return candidate;
+}
+
+
+
+void World::loadChunk(const ChunkPos lPos) {
+	TRACE_ZONE("World::loadChunk");
+	// Make sure that the chunk hasn't already been loaded (something has gone horribly wrong if it has)
+	assert(
+		(chunkStatusMap.getChunkStatusLoad(lPos) == StatusChunkLoad::NON_EXISTENT) &&
+		"Attempted to load already loaded chunk."
+	);
+	loadOrder.markLoaded(loadCandidateIndex);
+	chunkStatusMap.setChunkStatusLoad(lPos, StatusChunkLoad::LOADED);
+	chunkStatusMap.setChunkTimeRequested(lPos, loadOrder.getTimeRecentred());
+	TRACE_FLOW_BEGIN("Chunk", TRACE_CHUNK_ID(lPos));
+
+	// Unedited chunks that generate as a single block are only recorded as that block
+	std::optional<Block> _uniformBlock;
+	if (!editJournal.getEdits(lPos) && !regionStorage.hasChunk(lPos)) {
+		_uniformBlock = Chunk::getUniformGeneration(lPos, getGeneratorChunkParameters(ChunkPos2D(lPos)));
+	}
+	if (_uniformBlock) {
+		uniformChunks.insert(lPos, *_uniformBlock);
+		chunksLoadedUniform++;
 		chunkStatusMap.setChunkStatusLoad(lPos, StatusChunkLoad::GENERATED);
+	}
+	else {
+		// Chunks that were populated on an earlier visit are read back, otherwise the chunk is generated
+		auto insertRes = mapChunks.insert({ lPos, chunkPool.acquire(lPos) });
+		if (loadStoredChunk(*insertRes.first->second)) {
+			applyEdits(*insertRes.first->second);
+			chunkStatusMap.setChunkStatusLoad(lPos, StatusChunkLoad::POPULATED);
+			onChunkPopulated(lPos);
+		}
+		else {
+			insertRes.first->second->GenerateChunk(getGeneratorChunkParameters(ChunkPos2D(lPos)));
+			chunkStatusMap.setChunkStatusLoad(lPos, StatusChunkLoad::GENERATED);
+		}
+	}
 
-		// Check if it, or its neighbours can populate or load
-		ChunkPos2D _loadCentre2D(loadCentre);
-		const long long _loadDistanceHorizontalSquared = (
-			static_cast<long long>(settings.getLoadDistanceHorizontal()) *
-			settings.getLoadDistanceHorizontal()
-		);
-		for (auto [lX, lY, lZ] : CHUNK_NEIGHBOURHOOD) {
-			ChunkPos _pos(lPos.getX() + lX, lPos.getY() + lY, lPos.getZ() + lZ);
-			if (
-				_loadCentre2D.distanceEuclideanSquared(_pos) <= _loadDistanceHorizontalSquared &&
-				std::abs(loadCentre.getY() - _pos.getY()) <= settings.getLoadDistanceVertical()
-			) {
-				auto _status = chunkStatusMap.getChunkStatusLoad(_pos);
-				if (_status == StatusChunkLoad::NON_EXISTENT) {
-					loadQueue.push(ChunkPriorityTicket(chunkLoadPriority(_pos, loadCentre), _pos));
-					chunkStatusMap.setChunkStatusLoad(_pos, StatusChunkLoad::QUEUED_LOAD);
-				}
-				else if (_status == StatusChunkLoad::GENERATED && chunkStatusMap.getChunkStatusCanPopulate(_pos)) {
-					queueChunkForPopulation(_pos);
-				}
+	// Check if it, or its neighbours can populate
+	ChunkPos2D _loadCentre2D(loadCentre);
+	const long long _loadDistanceHorizontalSquared = (
+		static_cast<long long>(settings.getLoadDistanceHorizontal()) *
+		settings.getLoadDistanceHorizontal()
+	);
+	for (auto [lX, lY, lZ] : CHUNK_NEIGHBOURHOOD) {
+		ChunkPos _pos(lPos.getX() + lX, lPos.getY() + lY, lPos.getZ() + lZ);
+		if (
+			_loadCentre2D.distanceEuclideanSquared(_pos) <= _loadDistanceHorizontalSquared &&
+			std::abs(loadCentre.getY() - _pos.getY()) <= settings.getLoadDistanceVertical()
+		) {
+			auto _status = chunkStatusMap.getChunkStatusLoad(_pos);
+			if (_status == StatusChunkLoad::GENERATED && chunkStatusMap.getChunkStatusCanPopulate(_pos)) {
+				if (!populateUniformChunk(_pos)) queueChunkForPopulation(_pos);
 			}
 		}
 	}
@@ -376,94 +698,235 @@ void World::loadChunks() {
 
 
 
-void World::populateChunks() {
-	constexpr int MAX_POPULATE_COUNT = 25;
-	for (int i = 0; !populateQueue.empty() && i < MAX_POPULATE_COUNT; ++i) {
-		ChunkPos _pos = populateQueue.top().pos;
-		populateQueue.pop();
+void World::populateChunk() {
+	TRACE_ZONE("World::populateChunk");
+	ChunkPos _pos = populateQueue.top().pos;
+	populateQueue.pop();
 
-		// Make sure that the chunk is queued for population
-		assert(chunkStatusMap.getChunkStatusLoad(_pos) == StatusChunkLoad::QUEUED_POPULATE &&
-			"Attempted to populate already populated chunk."
-		);
+	// Make sure that the chunk is queued for population
+	assert(chunkStatusMap.getChunkStatusLoad(_pos) == StatusChunkLoad::QUEUED_POPULATE &&
+		"Attempted to populate already populated chunk."
+	);
+	if (populateUniformChunk(_pos)) return;
+
+	std::array<Chunk*, 26> neighbours{};
+	for (size_t i = 0; i < neighbours.size(); ++i) {
+		const auto [_dx, _dy, _dz] = CHUNK_NEIGHBOUR_OFFSETS[i];
+		const ChunkPos _neighbourPos(_pos.getX() + _dx, _pos.getY() + _dy, _pos.getZ() + _dz);
+		neighbours[i] = getChunk(_neighbourPos).get();
+		// Only happens when this chunk was populated before and has been unloaded since
+		const size_t _facingIndex = getNeighbourIndex(-_dx, -_dy, -_dz);
+		if (neighbours[i]->hasReleasedPopulationChanges(_facingIndex)) {
+			neighbours[i]->regeneratePopulationChanges(
+				getGeneratorChunkParameters(ChunkPos2D(_neighbourPos)), _facingIndex
+			);
+			populationChangesRegenerated++;
+		}
+	}
+	// Neighbours can still place blocks in a uniform chunk, so it needs a chunk of its own to populate into. If
+	// nothing was placed it goes back to being uniform.
+	Chunk& chunk = uniformChunks.contains(_pos) ? materialiseChunk(_pos) : *getChunk(_pos);
+	chunk.PopulateChunk(neighbours);
+	applyEdits(chunk);
+	TRACE_FLOW_STEP("Chunk", TRACE_CHUNK_ID(_pos));
+	if (auto _uniformBlock = chunk.getUniformBlock(); _uniformBlock && !editJournal.getEdits(_pos)) {
+		auto _node = mapChunks.extract(_pos);
+		chunkPool.release(std::move(_node.mapped()));
+		uniformChunks.insert(_pos, *_uniformBlock);
+	}
 
-		getChunk(_pos)->PopulateChunk(*this);
+	chunkStatusMap.setChunkStatusLoad(_pos, StatusChunkLoad::POPULATED);
+	onChunkPopulated(_pos);
+}
 
-		chunkStatusMap.setChunkStatusLoad(_pos, StatusChunkLoad::POPULATED);
-		// Check if this chunk or any cardinal neighbours can generate meshes
-		const int NEIGHBOURHOOD[7][3] = {
-			{ 0, 0, 0 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }
-		};
-		for (auto [_dx, _dy, _dz] : NEIGHBOURHOOD) {
-			ChunkPos meshPos(_pos.getX() + _dx, _pos.getY() + _dy, _pos.getZ() + _dz);
-			if (chunkStatusMap.getChunkStatusCanMesh(meshPos)) {
-				queueChunkForMeshing(meshPos);
-			}
+
+
+// A uniform chunk surrounded by uniform chunks has nothing to populate, so it is marked as populated straight away
+// instead of going through the population queue
+bool World::populateUniformChunk(const ChunkPos chunkPos) {
+	if (!uniformChunks.contains(chunkPos)) return false;
+	for (auto [_dx, _dy, _dz] : CHUNK_NEIGHBOUR_OFFSETS) {
+		if (!uniformChunks.contains(ChunkPos(chunkPos.getX() + _dx, chunkPos.getY() + _dy, chunkPos.getZ() + _dz))) {
+			return false;
 		}
 	}
+	chunkStatusMap.setChunkStatusLoad(chunkPos, StatusChunkLoad::POPULATED);
+	onChunkPopulated(chunkPos);
+	return true;
 }
 
 
 
-void World::meshChunks() {
-	std::queue<std::unique_ptr<MeshChunk::Data>> meshDataQueue;
+// Uniform chunks are turned into real chunks before they are written to, and are then kept as real chunks
+Chunk& World::materialiseChunk(const ChunkPos chunkPos) {
+	const std::optional<Block> _block = uniformChunks.erase(chunkPos);
+	assert(_block && "Attempted to materialise chunk that isn't uniform");
+	auto chunk = chunkPool.acquire(chunkPos);
+	chunk->fillUniform(*_block);
+	chunksMaterialised++;
+	return *mapChunks.insert({ chunkPos, std::move(chunk) }).first->second;
+}
 
-	constexpr int MAX_MESH_COUNT = 20;
-	for (int i = 0; i < MAX_MESH_COUNT; ++i) {
-		if (meshQueue.empty()) {
-			break;
-		}
 
-		ChunkPos mPos = meshQueue.top().pos;
-		meshQueue.pop();
 
-		// Make sure chunk is generated but does not have a mesh (the universe is broken if it isn't)
-		assert(
-			(chunkStatusMap.getChunkStatusLoad(mPos) == StatusChunkLoad::POPULATED) &&
-			"Attempted to create mesh for chunk that has not finished loading"
-		);
-		assert(
-			(chunkStatusMap.getChunkStatusMesh(mPos) == StatusChunkMesh::QUEUED) &&
-			"Attempted to regenerate mesh."
-		);
+void World::onChunkPopulated(const ChunkPos chunkPos) {
+	chunkDeduplicator.deduplicateBlocks(*getChunk(chunkPos), mapChunks);
 
-		// Create a mesh if the chunk is not empty
-		if (!getChunk(mPos)->shouldSkipMeshing()) {
-			std::array<Chunk*, 6> neighbours{};
-			for (unsigned j = 0; j < 6; ++j) {
-				neighbours[j] = getChunk(mPos.direction(static_cast<AxisDirection>(j))).get();
-			}
-			auto meshData = std::make_unique<MeshChunk::Data>(getChunk(mPos).get(), neighbours);
-			if (!meshData->isEmpty()) {
-				meshDataQueue.push(std::move(meshData));
-			}
+	// Check if this chunk or any cardinal neighbours can generate meshes
+	const int NEIGHBOURHOOD[7][3] = {
+		{ 0, 0, 0 }, { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }
+	};
+	for (auto [_dx, _dy, _dz] : NEIGHBOURHOOD) {
+		ChunkPos meshPos(chunkPos.getX() + _dx, chunkPos.getY() + _dy, chunkPos.getZ() + _dz);
+		if (!chunkStatusMap.getChunkStatusCanMesh(meshPos)) continue;
+		// Uniform air and solid chunks never have a mesh, so they skip the mesh queue
+		if (uniformChunks.contains(meshPos) && getChunk(meshPos)->shouldSkipMeshing()) {
+			chunkStatusMap.setChunkStatusMesh(meshPos, StatusChunkMesh::MESHED);
+			TRACE_FLOW_END("Chunk", TRACE_CHUNK_ID(meshPos));
 		}
-		chunkStatusMap.setChunkStatusMesh(mPos, StatusChunkMesh::MESHED);
+		else queueChunkForMeshing(meshPos);
 	}
+}
 
-	// Push meshes, if any were created
-	if (meshDataQueue.size()) {
-		sharedRendererState->chunkMeshQueue->mergeQueue(meshDataQueue);
+
+
+// A stored chunk that can't be read is logged and generated again, it is overwritten when it is next saved
+bool World::loadStoredChunk(Chunk& chunk) {
+	TRACE_ZONE("World::loadStoredChunk");
+	try {
+		auto data = regionStorage.readChunk(chunk.getPosition());
+		if (data.empty()) return false;
+		chunk.deserialize(data);
+	}
+	catch (const std::exception& e) {
+		LOG_WARNING(std::string("Failed to load stored chunk: ") + e.what());
+		chunk.reset(chunk.getPosition());
+		return false;
 	}
+	chunksLoadedFromStorage++;
+	return true;
 }
 
 
 
-// Returns a reference to a chunk
-const std::unique_ptr<Chunk>& World::getChunk(const ChunkPos chunkPos) const {
-	try {
-		return mapChunks.at(chunkPos);
+// Edits are made on top of the finished chunk, so they are applied after population or loading the stored chunk
+void World::applyEdits(Chunk& chunk) const {
+	const EditJournal::ChunkEdits* edits = editJournal.getEdits(chunk.getPosition());
+	if (!edits) return;
+	for (const auto& [_index, _block] : *edits) chunk.setBlock(ChunkLocalBlockPos(_index), _block);
+}
+
+
+
+// Writes out a chunk with enough edits in full, which replaces its edits in the journal once syncCheckpoints has put it
+// on disk. Only populated chunks can be written, as anything before that still depends on its neighbours
+void World::checkpointChunk(Chunk& chunk) {
+	const EditJournal::ChunkEdits* edits = editJournal.getEdits(chunk.getPosition());
+	if (
+		!edits ||
+		edits->size() < CHECKPOINT_EDIT_COUNT ||
+		chunkStatusMap.getChunkStatusLoad(chunk.getPosition()) != StatusChunkLoad::POPULATED
+	) {
+		return;
 	}
-	catch (const std::out_of_range& e)
-	{
-		std::string error = "Attempted to access non-existent chunk at ";
-		error += std::to_string(chunkPos.getX()) + " " + std::to_string(chunkPos.getY()) + " " + std::to_string(chunkPos.getZ());
-		throw EXCEPTION_WORLD::ChunkNonExistence(error);
+	TRACE_ZONE("World::checkpointChunk");
+	chunkSaveBuffer.clear();
+	chunk.serialize(chunkSaveBuffer);
+	if (regionStorage.writeChunk(chunk.getPosition(), chunkSaveBuffer)) {
+		unsyncedCheckpoints.push_back(chunk.getPosition());
 	}
 }
 
 
 
+// Checkpoints are written in batches and synced once, rather than syncing every chunk. If the sync fails the edits
+// stay in the journal, and are applied on top of whichever version of the chunk was stored.
+void World::syncCheckpoints() {
+	if (unsyncedCheckpoints.empty()) return;
+	TRACE_ZONE("World::syncCheckpoints");
+	if (regionStorage.sync()) {
+		for (const ChunkPos _pos : unsyncedCheckpoints) editJournal.recordCheckpoint(_pos);
+		chunksCheckpointed += unsyncedCheckpoints.size();
+	}
+	unsyncedCheckpoints.clear();
+}
+
+
+
+void World::checkpointEditedChunks() {
+	TRACE_ZONE("World::checkpointEditedChunks");
+	std::vector<ChunkPos> checkpointQueue;
+	for (const auto& [_pos, _edits] : editJournal.getAllEdits()) {
+		if (_edits.size() >= CHECKPOINT_EDIT_COUNT && mapChunks.contains(_pos)) checkpointQueue.push_back(_pos);
+	}
+	for (auto& _pos : checkpointQueue) checkpointChunk(*getChunk(_pos));
+	syncCheckpoints();
+}
+
+
+
+void World::closeDistantRegions() {
+	regionStorage.closeDistantRegions(
+		loadCentre,
+		settings.getLoadDistanceHorizontal() + settings.getUnloadMargin(),
+		settings.getLoadDistanceVertical() + settings.getUnloadMargin()
+	);
+}
+
+
+
+// Chunks with an empty mesh are marked as meshed without anything being sent to the renderer
+void World::meshChunk(std::queue<std::unique_ptr<MeshChunk::Data>>& meshDataQueue) {
+	TRACE_ZONE("World::meshChunk");
+	ChunkPos mPos = meshQueue.top().pos;
+	meshQueue.pop();
+
+	// Make sure chunk is generated but does not have a mesh (the universe is broken if it isn't)
+	assert(
+		(chunkStatusMap.getChunkStatusLoad(mPos) == StatusChunkLoad::POPULATED) &&
+		"Attempted to create mesh for chunk that has not finished loading"
+	);
+	assert(
+		(chunkStatusMap.getChunkStatusMesh(mPos) == StatusChunkMesh::QUEUED) &&
+		"Attempted to regenerate mesh."
+	);
+
+	// Create a mesh if the chunk is not empty
+	if (!getChunk(mPos)->shouldSkipMeshing()) {
+		std::array<Chunk*, 6> neighbours{};
+		for (unsigned j = 0; j < 6; ++j) {
+			neighbours[j] = getChunk(mPos.direction(static_cast<AxisDirection>(j))).get();
+		}
+		auto meshData = chunkDeduplicator.createMesh(getChunk(mPos).get(), neighbours);
+		if (!meshData->isEmpty()) {
+			auto timeRequested = chunkStatusMap.getChunkTimeRequested(mPos);
+			meshData->setTimeRequested(timeRequested);
+			sharedRendererState->worldProfiler.recordMeshed(mPos, timeRequested);
+			meshDataQueue.push(std::move(meshData));
+			TRACE_FLOW_STEP("Chunk", TRACE_CHUNK_ID(mPos));
+		}
+		// Chunks without a mesh never reach the renderer
+		else TRACE_FLOW_END("Chunk", TRACE_CHUNK_ID(mPos));
+	}
+	else TRACE_FLOW_END("Chunk", TRACE_CHUNK_ID(mPos));
+	chunkStatusMap.setChunkStatusMesh(mPos, StatusChunkMesh::MESHED);
+}
+
+
+
+// Returns a reference to a chunk
+const std::unique_ptr<Chunk>& World::getChunk(const ChunkPos chunkPos) const {
+	auto chunk = mapChunks.find(chunkPos);
+	if (chunk != mapChunks.end()) return chunk->second;
+	if (const std::unique_ptr<Chunk>* uniformChunk = uniformChunks.getChunk(chunkPos)) return *uniformChunk;
+
+	std::string error = "Attempted to access non-existent chunk at ";
+	error += std::to_string(chunkPos.getX()) + " " + std::to_string(chunkPos.getY()) + " " + std::to_string(chunkPos.getZ());
+	throw EXCEPTION_WORLD::ChunkNonExistence(error);
+}
+
+
+
 void World::addStructure(const BlockPos _blockPos, std::unique_ptr<Structure> _structure) {
 	mapStructures[_blockPos] = std::move(_structure);
 }
@@ -490,7 +953,7 @@ void World::queueChunkForMeshing(const ChunkPos chunkPos) {
 		chunkStatusMap.getChunkStatusCanMesh(chunkPos) &&
 		"Attempted to queue mesh that cannot be meshed"
 	);
-	meshQueue.push(ChunkPriorityTicket(chunkLoadPriority(chunkPos, loadCentre), chunkPos));
+	meshQueue.push(ChunkPriorityTicket(getChunkPriority(chunkPos), chunkPos));
 	chunkStatusMap.setChunkStatusMesh(chunkPos, StatusChunkMesh::QUEUED);
 }
 
@@ -501,12 +964,20 @@ void World::queueChunkForPopulation(const ChunkPos chunkPos) {
 		chunkStatusMap.getChunkStatusCanPopulate(chunkPos) &&
 		"Attempted to populate chunk that cannot be populated"
 	);
-	populateQueue.push(ChunkPriorityTicket(chunkLoadPriority(chunkPos, loadCentre), chunkPos));
+	populateQueue.push(ChunkPriorityTicket(getChunkPriority(chunkPos), chunkPos));
 	chunkStatusMap.setChunkStatusLoad(chunkPos, StatusChunkLoad::QUEUED_POPULATE);
 }
 
 
 
+double World::getChunkPriority(const ChunkPos chunkPos) const {
+	auto parameters = generatorChunkCache.find(ChunkPos2D(chunkPos));
+	const HeightMap* heightMap = parameters != generatorChunkCache.end() ? &parameters->second.getHeightMap() : nullptr;
+	return chunkLoadPriority(chunkPos, priorityView, heightMap);
+}
+
+
+
 const GeneratorChunkParameters& World::getGeneratorChunkParameters(const ChunkPos2D position) {
 	if (!generatorChunkCache.contains(position)) generatorChunkCache.try_emplace(position, position, generatorChunkNoise);
 	return generatorChunkCache.at(position);
@@ -1,27 +1,39 @@
 #pragma once
+#include <optional>
+#include <queue>
 #include <unordered_map>
 
 #include "Block.h"
 #include "BlockHash.h"
 #include "Chunk.h"
+#include "ChunkLoadOrder.h"
+#include "ChunkDeduplicator.h"
+#include "ChunkNeighbourhood.h"
+#include "ChunkLoadPriority.h"
+#include "ChunkPool.h"
+#include "ChunkPipelineScheduler.h"
 #include "ChunkStatusMap.h"
 #include "Entities/Entity.h"
 #include "Generation/GeneratorChunkParameters.h"
 #include "Generation/GeneratorChunkNoise.h"
 #include "Generation/Structures/Structure.h"
+#include "UniformChunkMap.h"
+#include "Storage/EditJournal.h"
+#include "Storage/RegionStorage.h"
 #include "../Settings.h"
 #include "../Rendering/Mesh/MeshChunk.h"
 #include "../Threading/SharedGameRendererState.h"
+#include "../Threading/SimulationClock.h"
 
 
 
 class ChunkPriorityTicket
 {
 public:
-	int priority;
+	double priority;
 	ChunkPos pos;
 
-	ChunkPriorityTicket(int _priority, ChunkPos _pos) : priority{ _priority }, pos{ _pos } {}
+	ChunkPriorityTicket(double _priority, ChunkPos _pos) : priority{ _priority }, pos{ _pos } {}
 
 	bool operator<(const ChunkPriorityTicket& other) const
 	{
@@ -39,12 +51,34 @@ private:
 	// Chunk storage
 	std::unordered_map<long long, Entity> mapEntities;
 	std::unordered_map<ChunkPos, std::unique_ptr<Chunk>> mapChunks;
+	// Loaded chunks that are a single block, which aren't in mapChunks
+	UniformChunkMap uniformChunks;
 	std::unordered_map<BlockPos, std::unique_ptr<Structure>> mapStructures;
 
 	// Chunk loading information
 	ChunkPos loadCentre;
+	ChunkPriorityView priorityView;
+	// The view that the queued priorities were calculated with
+	ChunkPriorityView priorityViewQueued;
 	ChunkStatusMap chunkStatusMap;
-	std::priority_queue<ChunkPriorityTicket> loadQueue;
+	ChunkLoadOrder loadOrder;
+	ChunkPool chunkPool;
+	ChunkDeduplicator chunkDeduplicator;
+	RegionStorage regionStorage;
+	EditJournal editJournal;
+	// Reused between checkpoints so that checkpointing doesn't allocate for every chunk
+	std::vector<u8> chunkSaveBuffer;
+	// Chunks written by checkpointChunk whose edits are dropped from the journal once storage is synced
+	std::vector<ChunkPos> unsyncedCheckpoints;
+	u64 chunksLoadedFromStorage = 0;
+	u64 chunksCheckpointed = 0;
+	u64 chunksLoadedUniform = 0;
+	u64 chunksMaterialised = 0;
+	u64 populationChangesRegenerated = 0;
+	// Number of load table entries the loading screen waits for, zero when not loading
+	size_t loadingRegionSize = 0;
+	// Position in the load table of the chunk returned by the last call to nextLoadCandidate
+	size_t loadCandidateIndex = 0;
 	std::priority_queue<ChunkPriorityTicket> populateQueue;
 	std::priority_queue<ChunkPriorityTicket> meshQueue;
 
@@ -54,34 +88,54 @@ private:
 
 	std::shared_ptr<SharedGameRendererState> sharedRendererState;
 
+	ChunkPipelineScheduler pipelineScheduler;
+
 private:
 	void processEntities(Entity& player);
 	void moveEntity(Entity& entity);
 	bool blockIsCollidable(BlockPos blockPos) const;
+	bool blockIsCollidable(const ChunkNeighbourhood& neighbourhood, BlockPos blockPos) const;
+	ChunkNeighbourhood getPopulatedNeighbourhood(const ChunkPos centre) const;
 	void onLoadCentreChange();
-	void loadChunks();
-	void populateChunks();
-	void meshChunks();
+	bool loadRegionsOverlap(const ChunkPos centreA, const ChunkPos centreB) const;
+	void onLoadCentreTeleport();
+	void updateLoadingProgress();
+	void rebuildChunkQueues();
+	void runChunkPipeline(const SimulationClock& simulationClock, WorldProfiler::TickRecord& tickRecord);
+	std::optional<ChunkPriorityTicket> nextLoadCandidate();
+	void loadChunk(const ChunkPos lPos);
+	Chunk& materialiseChunk(const ChunkPos chunkPos);
+	bool loadStoredChunk(Chunk& chunk);
+	void applyEdits(Chunk& chunk) const;
+	void checkpointChunk(Chunk& chunk);
+	void syncCheckpoints();
+	void checkpointEditedChunks();
+	void closeDistantRegions();
+	void populateChunk();
+	bool populateUniformChunk(const ChunkPos chunkPos);
+	void onChunkPopulated(const ChunkPos chunkPos);
+	void meshChunk(std::queue<std::unique_ptr<MeshChunk::Data>>& meshDataQueue);
 	void queueChunkForMeshing(const ChunkPos chunkPos);
 	void queueChunkForPopulation(const ChunkPos chunkPos);
+	double getChunkPriority(const ChunkPos chunkPos) const;
 	const GeneratorChunkParameters& getGeneratorChunkParameters(const ChunkPos2D position);
 	
 public:
 	World(
 		const Settings& _settings,
-		std::shared_ptr<SharedGameRendererState> _sharedRendererState,
-		const char* settingNoiseHeightmap
+		std::shared_ptr<SharedGameRendererState> _sharedRendererState
 	);
+	~World();
 
 	World(World&&) = delete;
 	World(const World&) = delete;
 	World operator=(World&&) = delete;
 	World operator=(const World&) = delete;
 	
-	void tick(Entity& player);
+	void tick(Entity& player, const SimulationClock& simulationClock);
 
 	Block getBlock(BlockPos blockPos) const;
-	void setBlock(BlockPos blockPos, Block block) const;
+	void setBlock(BlockPos blockPos, Block block);
 	const std::unique_ptr<Chunk>& getChunk(const ChunkPos chunkPos) const;
 
 	void addStructure(const BlockPos _blockPos, std::unique_ptr<Structure> _structure);
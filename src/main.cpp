@@ -6,18 +6,20 @@
 
 
 int main() {
+	installLogCrashHandlers();
+
 	try {
 		Application app;
 		app.run();
 	}
 	catch (const std::exception& error) {
-		GlobalLog.Write(std::string("Exception occurred: ") + error.what());
+		LOG_ERROR(std::string("Exception occurred: ") + error.what());
 	}
 	catch (...) {
-		GlobalLog.Write("What the fuck. Something has gone horribly wrong.");
+		LOG_ERROR("What the fuck. Something has gone horribly wrong.");
 	}
 
-	GlobalLog.Write("Application termination");
+	LOG_INFO("Application termination");
 
 	return 0;
 }